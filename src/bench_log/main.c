@@ -0,0 +1,64 @@
+/*  bench_log/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       bench_log/main.c
+ *  @brief      Measure how many messages per second `ezc_log` can take.
+ *  @details    Usage: `bench_log [messages]`. Nothing is echoed, so this
+ *              measures formatting and storing the message only, first in
+ *              text mode and then in binary mode.
+ */
+
+#include "ezc/ezc_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+
+int main(int argc, char *argv[])
+{
+    long const TOTAL = (argc > 1 ? atol(argv[1]) : 1000000);
+    static char const * const MODES[] = { "text", "binary" };
+    long i, mode;
+    clock_t start, stop;
+    double seconds;
+
+    for (mode = EZC_LOG_MODE_TEXT; mode <= EZC_LOG_MODE_BINARY; mode++)
+    {
+        ezc_log_mode(mode);
+        ezc_log_clear();
+        start = clock();
+
+        for (i = 0; i < TOTAL; i++)
+        {
+            ezc_log(EZC_LOG_INFO, "Processed item %li of %li (%s).", i,
+                    TOTAL, "benchmark");
+        }
+
+        stop = clock();
+        seconds = (double) (stop - start) / CLOCKS_PER_SEC;
+
+        printf("%s: %li messages in %.3f s: %.0f messages/s\n", MODES[mode],
+                TOTAL, seconds, seconds > 0 ? TOTAL / seconds : 0.0);
+    }
+
+    return 0;
+}
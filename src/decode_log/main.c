@@ -0,0 +1,56 @@
+/*  decode_log/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       decode_log/main.c
+ *  @brief      Turn a binary log dump back into text.
+ *  @details    Usage: `decode_log [-j] [dump]`. Reads the dump written by
+ *              `ezc_log_dump` from the given file, or from `stdin`, and
+ *              writes the formatted messages to `stdout`. With `-j` they
+ *              are written as JSON Lines instead.
+ */
+
+#include "ezc/ezc_log.h"
+#include <stdio.h>
+#include <string.h>
+
+
+
+int main(int argc, char *argv[])
+{
+    int const JSON = (argc > 1 && strcmp(argv[1], "-j") == 0);
+    char const * const PATH = (argc > 1 + JSON ? argv[1 + JSON] : NULL);
+    FILE *src = (PATH != NULL ? fopen(PATH, "rb") : stdin);
+    long decoded;
+
+    if (src == NULL)
+    {
+        fprintf(stderr, "Unable to open \"%s\".\n", PATH);
+        return 1;
+    }
+
+    ezc_log_echo(stderr);
+    decoded = (JSON ? ezc_log_decode_json(src, stdout) :
+            ezc_log_decode(src, stdout));
+
+    if (src != stdin) fclose(src);
+
+    return decoded < 0;
+}
@@ -0,0 +1,243 @@
+/*  ezc_arena.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_arena.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_mem.h"
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+
+
+/* Usable size of chunks unless `ezc_arena_new` says otherwise. */
+#define EZC_ARENA_DEFAULT_CHUNK_SIZE 65536L
+
+
+
+/* Whatever needs the strictest alignment */
+typedef union ezc_arena_max
+{
+    long l;
+    double d;
+    long double ld;
+    void *p;
+    void (*fn)(void);
+}
+ezc_arena_max;
+
+typedef struct ezc_arena_align
+{
+    char c;
+    ezc_arena_max max;
+}
+ezc_arena_align;
+
+#define EZC_ARENA_MAX_ALIGN ((long) offsetof(ezc_arena_align, max))
+
+
+
+/* Chunk header. The union pads it to a multiple of the strictest alignment,
+ * so the usable memory right behind it is suitably aligned as well. */
+typedef struct ezc_arena_chunk
+{
+    struct ezc_arena_chunk *prev;
+    char *end;
+    ezc_arena_max align;
+}
+ezc_arena_chunk;
+
+#define EZC_ARENA_DATA(chunk) ((char *) ((chunk) + 1))
+
+
+
+/* Start a new chunk with room for at least `size` bytes */
+static int ezc_arena_grow(ezc_arena *self, long size)
+{
+    ezc_arena_chunk *chunk;
+
+    if (size < self->chunk_size) size = self->chunk_size;
+
+    if (size > LONG_MAX - (long) sizeof *chunk ||
+            (chunk = EZC_MEM_ALLOC(EZC_MEM_GLOBAL,
+                                   sizeof *chunk + size)) == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to grow arena by %li bytes.", size);
+        return -1;
+    }
+
+    chunk->prev = self->chunk;
+    chunk->end = EZC_ARENA_DATA(chunk) + size;
+
+    self->chunk = chunk;
+    self->cursor = EZC_ARENA_DATA(chunk);
+    self->end = chunk->end;
+
+    return 0;
+}
+
+
+
+ezc_arena* ezc_arena_new(long chunk_size)
+{
+    ezc_arena *self;
+    EZC_NEW(self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate arena.");
+        return NULL;
+    }
+
+    self->chunk = NULL;
+    self->cursor = NULL;
+    self->end = NULL;
+    self->chunk_size = (chunk_size > 0 ? chunk_size :
+            EZC_ARENA_DEFAULT_CHUNK_SIZE);
+
+    return self;
+}
+
+
+
+void ezc_arena_delete__(ezc_arena *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        ezc_arena_mark empty;
+
+        empty.chunk = NULL;
+        empty.cursor = NULL;
+
+        ezc_arena_rewind(self, empty);
+        EZC_FREE(self);
+
+        self = va_arg(arg_ptr, ezc_arena*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void* ezc_arena_alloc(ezc_arena *self, long size, long align)
+{
+    assert(self != NULL && size >= 0 && (align & (align - 1)) == 0);
+
+    long padding;
+
+    if (align <= 0) align = EZC_ARENA_MAX_ALIGN;
+
+    padding = (long) (-(unsigned long) self->cursor & (align - 1));
+
+    if (self->chunk == NULL || self->end - self->cursor < padding ||
+            self->end - self->cursor - padding < size)
+    {
+        if (size > LONG_MAX - align ||
+                ezc_arena_grow(self, size + align - 1) != 0)
+        {
+            return NULL;
+        }
+
+        padding = (long) (-(unsigned long) self->cursor & (align - 1));
+    }
+
+    self->cursor += padding + size;
+    return self->cursor - size;
+}
+
+
+
+void* ezc_arena_calloc(ezc_arena *self, long n, long size)
+{
+    void *data;
+
+    if (n < 0 || size < 0 || (size > 0 && n > LONG_MAX / size))
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate %li times %li bytes from "
+                "arena.", n, size);
+        return NULL;
+    }
+
+    data = ezc_arena_alloc(self, n * size, 0);
+    if (data != NULL) memset(data, 0, n * size);
+
+    return data;
+}
+
+
+
+ezc_arena_mark ezc_arena_save(ezc_arena const *self)
+{
+    assert(self != NULL);
+
+    ezc_arena_mark mark;
+
+    mark.chunk = self->chunk;
+    mark.cursor = self->cursor;
+
+    return mark;
+}
+
+
+
+void ezc_arena_rewind(ezc_arena *self, ezc_arena_mark mark)
+{
+    assert(self != NULL);
+
+    while (self->chunk != mark.chunk && self->chunk != NULL)
+    {
+        ezc_arena_chunk *chunk = self->chunk;
+
+        self->chunk = chunk->prev;
+        EZC_FREE(chunk);
+    }
+
+    self->cursor = mark.cursor;
+    self->end = (self->chunk != NULL ? self->chunk->end : NULL);
+}
+
+
+
+void ezc_arena_release(ezc_arena *self)
+{
+    assert(self != NULL);
+
+    ezc_arena_mark oldest;
+
+    oldest.chunk = self->chunk;
+
+    while (oldest.chunk != NULL && oldest.chunk->prev != NULL)
+    {
+        oldest.chunk = oldest.chunk->prev;
+    }
+
+    oldest.cursor = (oldest.chunk != NULL ? EZC_ARENA_DATA(oldest.chunk) :
+            NULL);
+
+    ezc_arena_rewind(self, oldest);
+}
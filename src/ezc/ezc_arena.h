@@ -0,0 +1,200 @@
+/*  ezc_arena.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_ARENA_H
+#define EZC_ARENA_H
+
+/** @file       ezc_arena.h
+ *  @brief      Arena allocator, i.e. bump-pointer allocation.
+ *  @details    An arena hands out memory from large chunks by simply moving
+ *              a cursor forward. Nothing allocated from it is ever freed on
+ *              its own. Instead, everything allocated since a mark is freed
+ *              at once by `ezc_arena_rewind`, and everything at all by
+ *              `ezc_arena_release`. Meant for data that lives and dies
+ *              together, e.g. everything belonging to a single request. An
+ *              arena is not thread-safe.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_macro.h"
+
+
+
+/** @brief      Arena structure.
+ *  @details    Feel free to read the members directly, but only modify them
+ *              via the functions below.
+ */
+typedef struct ezc_arena
+{
+    /** Newest chunk, which allocations are carved out of. Chunks are
+     *  linked from newest to oldest. `NULL` until the first allocation. */
+    struct ezc_arena_chunk *chunk;
+
+    /** Next free byte of `chunk`. */
+    char *cursor;
+
+    /** End of `chunk`. */
+    char *end;
+
+    /** Usable size of regular chunks. */
+    long chunk_size;
+}
+ezc_arena;
+
+
+
+/** @brief      Position in an arena to rewind to later.
+ *  @details    See `ezc_arena_save`.
+ */
+typedef struct ezc_arena_mark
+{
+    /** Chunk that was the newest. */
+    struct ezc_arena_chunk *chunk;
+
+    /** Where its cursor was. */
+    char *cursor;
+}
+ezc_arena_mark;
+
+
+
+/** @brief      Allocate memory from an arena based on the size of the given
+ *              pointer.
+ *  @details    Arena counterpart of `EZC_NEW`. The memory is aligned for any
+ *              type.
+ *  @param      arena   `ezc_arena *` Arena to allocate from.
+ *  @param      ptr     Pointer to which you want memory allocated.
+ */
+#define EZC_ARENA_NEW(arena, ptr) \
+    ((ptr) = ezc_arena_alloc((arena), sizeof *(ptr), 0))
+
+
+
+/** @brief      Allocate zero-initialized memory from an arena based on the
+ *              size of the given pointer.
+ *  @details    Arena counterpart of `EZC_NEW0`.
+ *  @param      arena   `ezc_arena *` Arena to allocate from.
+ *  @param      ptr     Pointer to which you want memory allocated.
+ */
+#define EZC_ARENA_NEW0(arena, ptr) \
+    ((ptr) = ezc_arena_calloc((arena), 1, sizeof *(ptr)))
+
+
+
+/** @brief      Allocate a zero-initialized array from an arena.
+ *  @details    Arena counterpart of `EZC_NEWN`.
+ *  @param      arena   `ezc_arena *` Arena to allocate from.
+ *  @param      ptr     Pointer to which you want memory allocated.
+ *  @param      n       Number of elements.
+ */
+#define EZC_ARENA_NEWN(arena, ptr, n) \
+    ((ptr) = ezc_arena_calloc((arena), (n), sizeof *(ptr)))
+
+
+
+/** @brief      Create a new, empty arena.
+ *  @details    No memory is reserved until the first allocation.
+ *  @param      chunk_size  Size of the chunks to allocate from, in bytes.
+ *                          `0` or less for 64 KiB. Larger allocations get
+ *                          a chunk of their own.
+ *  @returns    `ezc_arena *` Pointer to allocated arena, or `NULL`.
+ */
+ezc_arena* ezc_arena_new(long chunk_size);
+
+
+
+/** @brief      Free given arenas and everything allocated from them.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers.
+ *  @param      self    `ezc_arena *` Pointer to an arena.
+ *  @param      ...     `ezc_arena *` Optional pointers to additional arenas
+ *                      to be freed.
+ *  @returns    N/A
+ */
+#define ezc_arena_delete(self, ...) \
+    (ezc_arena_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_arena_delete__(ezc_arena *self, ...);
+
+
+
+/** @brief      Allocate memory from an arena.
+ *  @param      self    Pointer to an arena.
+ *  @param      size    Number of bytes.
+ *  @param      align   Alignment in bytes, a power of two. `0` to suit any
+ *                      type.
+ *  @returns    Pointer to the memory, or `NULL` if it could not be
+ *              allocated.
+ */
+void* ezc_arena_alloc(ezc_arena *self, long size, long align);
+
+
+
+/** @brief      Allocate a zero-initialized array from an arena.
+ *  @details    Arena counterpart of `calloc`. Suits any type.
+ *  @param      self    Pointer to an arena.
+ *  @param      n       Number of elements.
+ *  @param      size    Size of each element in bytes.
+ *  @returns    Pointer to the memory, or `NULL` if it could not be
+ *              allocated.
+ */
+void* ezc_arena_calloc(ezc_arena *self, long n, long size);
+
+
+
+/** @brief      Remember the current position of an arena.
+ *  @param      self    Pointer to an arena.
+ *  @returns    Mark to pass to `ezc_arena_rewind`.
+ */
+ezc_arena_mark ezc_arena_save(ezc_arena const *self);
+
+
+
+/** @brief      Free everything allocated since a mark was saved.
+ *  @details    Chunks started since then are handed back to the system.
+ *              Marks saved after `mark` become invalid, and so do marks
+ *              saved before `ezc_arena_release` was last called.
+ *  @param      self    Pointer to an arena.
+ *  @param      mark    Mark returned by `ezc_arena_save`.
+ */
+void ezc_arena_rewind(ezc_arena *self, ezc_arena_mark mark);
+
+
+
+/** @brief      Free everything allocated from an arena.
+ *  @details    Unlike `ezc_arena_delete`, the arena stays usable, and it
+ *              keeps its oldest chunk around for upcoming allocations.
+ *  @param      self    Pointer to an arena.
+ */
+void ezc_arena_release(ezc_arena *self);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_ARENA_H */
@@ -0,0 +1,99 @@
+/*  ezc_atomic.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_ATOMIC_H
+#define EZC_ATOMIC_H
+
+/** @file       ezc_atomic.h
+ *  @brief      Atomic operations on integers and pointers.
+ *  @details    C89 has no notion of atomics, so these macros wrap the atomic
+ *              builtins of GCC (4.7 and up) and Clang. They work on any
+ *              properly aligned integer or pointer variable.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+
+
+/** @brief      Atomically read a variable.
+ *  @details    Later reads and writes of the calling thread cannot be
+ *              reordered before it (acquire semantics).
+ *  @param      ptr     Pointer to the variable.
+ *  @returns    The variable's value.
+ */
+#define EZC_ATOMIC_LOAD(ptr) \
+    (__atomic_load_n((ptr), __ATOMIC_ACQUIRE))
+
+
+
+/** @brief      Atomically write a variable.
+ *  @details    Earlier reads and writes of the calling thread cannot be
+ *              reordered after it (release semantics).
+ *  @param      ptr     Pointer to the variable.
+ *  @param      val     Value to write.
+ *  @returns    N/A
+ */
+#define EZC_ATOMIC_STORE(ptr, val) \
+    (__atomic_store_n((ptr), (val), __ATOMIC_RELEASE))
+
+
+
+/** @brief      Atomically add to a variable.
+ *  @param      ptr     Pointer to the variable.
+ *  @param      val     Value to add. May be negative.
+ *  @returns    The variable's value <i>before</i> the addition.
+ */
+#define EZC_ATOMIC_ADD(ptr, val) \
+    (__atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL))
+
+
+
+/** @brief      Atomically replace a variable.
+ *  @param      ptr     Pointer to the variable.
+ *  @param      val     Value to write.
+ *  @returns    The variable's value <i>before</i> it was replaced.
+ */
+#define EZC_ATOMIC_EXCHANGE(ptr, val) \
+    (__atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL))
+
+
+
+/** @brief      Atomically compare and swap a variable.
+ *  @details    Writes `desired` only if the variable still equals
+ *              `expected`. Acts as a full memory barrier.
+ *  @param      ptr         Pointer to the variable.
+ *  @param      expected    Value the variable must have.
+ *  @param      desired     Value to write.
+ *  @returns    Nonzero if `desired` was written.
+ */
+#define EZC_ATOMIC_CAS(ptr, expected, desired) \
+    (__sync_bool_compare_and_swap((ptr), (expected), (desired)))
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_ATOMIC_H */
@@ -20,36 +20,86 @@
  */
 
 #include "ezc/ezc_callback.h"
+#include "ezc/ezc_atomic.h"
 #include "ezc/ezc_log.h"
 #include "ezc/ezc_mem.h"
 
 
 
-typedef struct ezc_callback
+/* Callbacks are small and short-lived, so they all come from one pool. */
+static ezc_mem_pool *EZC_CALLBACK_POOL = NULL;
+
+
+
+/* Made on first use. A failed attempt is retried by the next callback. */
+static ezc_mem_pool* ezc_callback_pool()
 {
-    void (*fn)(void*);
-    void *arg;
+    ezc_mem_pool *pool = EZC_ATOMIC_LOAD(&EZC_CALLBACK_POOL);
+
+    if (pool == NULL)
+    {
+        pool = ezc_mem_pool_new(sizeof(ezc_callback));
+
+        if (pool == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Unable to allocate callback pool.");
+            return NULL;
+        }
+
+        /* Whoever loses the race to create the pool throws theirs away */
+        if (EZC_ATOMIC_CAS(&EZC_CALLBACK_POOL, NULL, pool))
+        {
+            EZC_MEM_KEEP(pool);
+        }
+        else
+        {
+            ezc_mem_pool_delete(pool);
+            pool = EZC_ATOMIC_LOAD(&EZC_CALLBACK_POOL);
+        }
+    }
+
+    return pool;
 }
-ezc_callback;
 
 
 
 ezc_callback* ezc_callback_new(void (*fn)(void*), void *arg)
 {
+    ezc_mem_pool * const POOL = ezc_callback_pool();
     ezc_callback *self;
-    EZC_NEW(self);
 
-    self->fn = fn;
-    self->arg = arg;
+    if (POOL == NULL) return NULL;
+
+    self = ezc_mem_pool_alloc(POOL);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate callback.");
+        return NULL;
+    }
+
+    ezc_callback_init(self, fn, arg);
 
     return self;
 }
 
 
 
+void ezc_callback_init(ezc_callback *self, void (*fn)(void*), void *arg)
+{
+    self->fn = fn;
+    self->arg = arg;
+}
+
+
+
 void ezc_callback_delete(ezc_callback *self)
 {
-    EZC_FREE(self);
+    /* A callback only exists once the pool does */
+    if (self != NULL)
+    {
+        ezc_mem_pool_free(EZC_ATOMIC_LOAD(&EZC_CALLBACK_POOL), self);
+    }
 }
 
 
@@ -65,3 +115,21 @@ void ezc_callback_call(ezc_callback const *self)
         ezc_log(EZC_LOG_WARN, "Attempting to use uninitialized callback.");
     }
 }
+
+
+
+void ezc_callback_call_batch(ezc_callback const *array, long n)
+{
+    long i;
+
+    if (array == NULL && n > 0)
+    {
+        ezc_log(EZC_LOG_WARN, "Attempting to use uninitialized callbacks.");
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        (*array[i].fn)(array[i].arg);
+    }
+}
@@ -25,7 +25,8 @@
 /** @file       ezc_callback.h
  *  @brief      Callback/Observer interface.
  *  @details    Can be made into the observer design pattern when coupled with
- *              `ezc_list`.
+ *              `ezc_list`, though `ezc_event` does that for you with
+ *              topics and cheap unsubscription.
  */
 
 #ifdef __cplusplus
@@ -36,26 +37,60 @@ extern C
 
 
 /** @brief      Callback object.
- *  @details    This is an opaque `struct`. Please use the provided interface
- *              to interact with it.
+ *  @details    Small enough to be kept by value, e.g. on the stack or in an
+ *              array, see `ezc_callback_init` and `EZC_CALLBACK`. Callbacks
+ *              made by `ezc_callback_new` come from a pool instead.
  */
-typedef struct ezc_callback ezc_callback;
+typedef struct ezc_callback
+{
+    /** Function to call. */
+    void (*fn)(void*);
+
+    /** Argument to call it with. */
+    void *arg;
+}
+ezc_callback;
+
+
+
+/** @brief      Initializer for a callback object kept by value.
+ *  @details    E.g. `ezc_callback cb = EZC_CALLBACK(fn, &data);`, or as the
+ *              elements of an array initializer. In C89 only constant
+ *              expressions may appear in the latter.
+ *  @param      fn      Pointer to a function. See `ezc_callback_new`.
+ *  @param      arg     `void *` Pointer to data that you want passed to `fn`.
+ */
+#define EZC_CALLBACK(fn, arg) \
+    { (void (*)(void*)) (fn), (void *) (arg) }
 
 
 
 /** @brief      Create a new callback object.
- *  @details    As of now there are no "setter" methods that allow you to
- *              change this object's values later. (Instead, delete and
- *              recreate the object instead.)
+ *  @details    To change this object's values later, call
+ *              `ezc_callback_init` on it again. Callback objects come from a
+ *              pool shared by all threads, see `ezc_mem_pool`, so creating
+ *              and deleting them is cheap.
  *  @param      fn      Pointer to a function. This function must accept one
  *                      argument, a pointer to the same type as `arg`.
  *  @param      arg     `void *` Pointer to data that you want passed to `fn`.
- *  @returns    Pointer to newly allocated callback object.
+ *  @returns    Pointer to newly allocated callback object, or `NULL` if it
+ *              could not be allocated.
  */
 ezc_callback* ezc_callback_new(void (*fn)(void*), void *arg);
 
 
 
+/** @brief      Initialize a callback object kept by value.
+ *  @details    Unlike `ezc_callback_new` this does not allocate anything, so
+ *              there is nothing to delete afterwards.
+ *  @param      self    Pointer to the callback object to initialize.
+ *  @param      fn      Pointer to a function. See `ezc_callback_new`.
+ *  @param      arg     `void *` Pointer to data that you want passed to `fn`.
+ */
+void ezc_callback_init(ezc_callback *self, void (*fn)(void*), void *arg);
+
+
+
 /** @brief      Free given callback object.
  *  @param      self    `ezc_callback *` Pointer to a callback object.
  */
@@ -70,6 +105,17 @@ void ezc_callback_call(ezc_callback const *self);
 
 
 
+/** @brief      Perform every callback of an array, in order.
+ *  @details    Much cheaper than calling `ezc_callback_call` on each of them
+ *              through a list, as the callbacks are read straight out of the
+ *              array.
+ *  @param      array   `ezc_callback const *` Array of callback objects.
+ *  @param      n       Number of callbacks in the array.
+ */
+void ezc_callback_call_batch(ezc_callback const *array, long n);
+
+
+
 #ifdef __cplusplus
 }
 #endif
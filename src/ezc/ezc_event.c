@@ -0,0 +1,343 @@
+/*  ezc_event.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_event.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_map.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+#include <string.h>
+
+
+
+typedef struct ezc_event_sub ezc_event_sub;
+typedef struct ezc_event_topic ezc_event_topic;
+
+
+
+/* A subscriber as stored in its topic. Unsubscribing leaves a tombstone with
+ * `fn == NULL` behind, which is compacted away once no message is being
+ * published on the topic. */
+typedef struct ezc_event_slot
+{
+    void (*fn)(void*, void*);
+    void *arg;
+    ezc_event_sub *sub;
+}
+ezc_event_slot;
+
+
+
+/* Where a subscription currently lives, kept up to date by compaction */
+struct ezc_event_sub
+{
+    ezc_event_topic *topic;
+    long index;
+};
+
+
+
+struct ezc_event_topic
+{
+    /* Key in `ezc_event::topics`, owned by the topic */
+    char *name;
+
+    ezc_event_slot *slots;
+    long length, capacity;
+
+    /* Number of tombstones among the slots */
+    long dead;
+
+    /* Number of publishes in progress, which may be nested */
+    long publishing;
+};
+
+
+
+struct ezc_event
+{
+    /* Topic name to `ezc_event_topic *` */
+    ezc_map *topics;
+
+    /* Handle to `ezc_event_sub *` */
+    ezc_map *subs;
+
+    ezc_event_handle next;
+};
+
+
+
+/* Move live slots to the front, in order, and forget the tombstones */
+static void ezc_event_compact(ezc_event_topic *topic)
+{
+    long i, kept = 0;
+
+    for (i = 0; i < topic->length; i++)
+    {
+        if (topic->slots[i].fn != NULL)
+        {
+            topic->slots[kept] = topic->slots[i];
+            topic->slots[kept].sub->index = kept;
+            kept++;
+        }
+    }
+
+    topic->length = kept;
+    topic->dead = 0;
+}
+
+
+
+/* Compact once at least half the slots are tombstones, which keeps both
+ * unsubscribing and publishing amortized `O(1)` per subscriber */
+static void ezc_event_tidy(ezc_event_topic *topic)
+{
+    if (topic->publishing == 0 && topic->dead > 0 &&
+            topic->dead * 2 >= topic->length)
+    {
+        ezc_event_compact(topic);
+    }
+}
+
+
+
+/* `strcmp` for the keys of `ezc_event::topics` */
+static int ezc_event_name_neq(void const *a, void const *b)
+{
+    return strcmp(a, b);
+}
+
+
+
+static ezc_event_topic* ezc_event_topic_new(ezc_event *self, char const *name)
+{
+    ezc_event_topic *topic;
+    long const SIZE = strlen(name) + 1;
+
+    EZC_NEW0(topic);
+
+    if (topic != NULL &&
+            (topic->name = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, SIZE)) != NULL)
+    {
+        memcpy(topic->name, name, SIZE);
+
+        if (ezc_map_set(self->topics, topic->name, topic) == 0) return topic;
+        EZC_FREE(topic->name);
+    }
+
+    EZC_FREE(topic);
+    return NULL;
+}
+
+
+
+/* Called with each entry of `ezc_event::topics`, whose key is the topic's
+ * own name */
+static void ezc_event_topic_delete(void *name, ezc_event_topic *topic)
+{
+    long i;
+
+    for (i = 0; i < topic->length; i++)
+    {
+        EZC_FREE(topic->slots[i].sub);
+    }
+
+    EZC_FREE(topic->slots, name);
+    EZC_FREE(topic);
+}
+
+
+
+ezc_event* ezc_event_new()
+{
+    ezc_event *self;
+    EZC_NEW(self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate event bus.");
+        return NULL;
+    }
+
+    self->topics = ezc_map_new(ezc_map_hash_str, ezc_event_name_neq);
+    self->subs = ezc_map_new(NULL, NULL);
+    self->next = 1;
+
+    if (self->topics == NULL || self->subs == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate event bus.");
+        if (self->topics != NULL) ezc_map_delete(self->topics);
+        if (self->subs != NULL) ezc_map_delete(self->subs);
+        EZC_FREE(self);
+    }
+
+    return self;
+}
+
+
+
+void ezc_event_delete__(ezc_event *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        assert(self->topics != NULL);
+
+        ezc_map_map(self->topics, ezc_event_topic_delete);
+        ezc_map_delete(self->topics, self->subs);
+        EZC_FREE(self);
+
+        self = va_arg(arg_ptr, ezc_event*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+ezc_event_handle ezc_event_subscribe(ezc_event *self, char const *topic,
+                                     void (*fn)(void*, void*), void *arg)
+{
+    assert(self != NULL && topic != NULL && fn != NULL);
+
+    ezc_event_topic *found = ezc_map_get(self->topics, topic);
+    ezc_event_handle const HANDLE = self->next;
+    ezc_event_slot *slot;
+    ezc_event_sub *sub;
+
+    if (found == NULL && (found = ezc_event_topic_new(self, topic)) == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to create topic \"%s\".", topic);
+        return 0;
+    }
+
+    /* Slots only ever grow while publishing, so indices stay put */
+    if (found->length == found->capacity)
+    {
+        long const CAPACITY = (found->capacity > 0 ? found->capacity * 2 : 4);
+        ezc_event_slot *slots = EZC_MEM_REALLOC(EZC_MEM_GLOBAL, found->slots,
+                CAPACITY * sizeof *slots);
+
+        if (slots == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Unable to grow topic \"%s\" to %li "
+                    "subscribers.", topic, CAPACITY);
+            return 0;
+        }
+
+        found->slots = slots;
+        found->capacity = CAPACITY;
+    }
+
+    EZC_NEW(sub);
+
+    if (sub == NULL || ezc_map_set(self->subs, (void *) HANDLE, sub) != 0)
+    {
+        EZC_FREE(sub);
+        ezc_log(EZC_LOG_ERROR, "Unable to subscribe to topic \"%s\".", topic);
+        return 0;
+    }
+
+    sub->topic = found;
+    sub->index = found->length;
+
+    slot = &found->slots[found->length++];
+    slot->fn = fn;
+    slot->arg = arg;
+    slot->sub = sub;
+
+    self->next++;
+    return HANDLE;
+}
+
+
+
+int ezc_event_unsubscribe(ezc_event *self, ezc_event_handle handle)
+{
+    assert(self != NULL);
+
+    ezc_event_sub *sub = (handle != 0 ?
+            ezc_map_pop(self->subs, (void *) handle) : NULL);
+    ezc_event_topic *topic;
+
+    if (sub == NULL)
+    {
+        ezc_log(EZC_LOG_WARN, "Unable to unsubscribe #%li. No such "
+                "subscription.", handle);
+        return -1;
+    }
+
+    topic = sub->topic;
+    topic->slots[sub->index].fn = NULL;
+    topic->slots[sub->index].sub = NULL;
+    topic->dead++;
+    EZC_FREE(sub);
+
+    ezc_event_tidy(topic);
+    return 0;
+}
+
+
+
+long ezc_event_publish(ezc_event *self, char const *topic, void *data)
+{
+    assert(self != NULL && topic != NULL);
+
+    ezc_event_topic * const found = ezc_map_get(self->topics, topic);
+    long i, length, called = 0;
+
+    if (found == NULL) return 0;
+
+    /* Subscribers added from now on wait for the next message. The slots
+     * may move when they are added, so they are looked up every time. */
+    length = found->length;
+    found->publishing++;
+
+    for (i = 0; i < length; i++)
+    {
+        ezc_event_slot const slot = found->slots[i];
+
+        if (slot.fn != NULL)
+        {
+            (*slot.fn)(slot.arg, data);
+            called++;
+        }
+    }
+
+    found->publishing--;
+    ezc_event_tidy(found);
+
+    return called;
+}
+
+
+
+long ezc_event_length(ezc_event const *self, char const *topic)
+{
+    assert(self != NULL && topic != NULL);
+
+    ezc_event_topic const * const found = ezc_map_get(self->topics, topic);
+    return found != NULL ? found->length - found->dead : 0;
+}
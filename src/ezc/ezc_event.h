@@ -0,0 +1,137 @@
+/*  ezc_event.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_EVENT_H
+#define EZC_EVENT_H
+
+/** @file       ezc_event.h
+ *  @brief      Event bus, i.e. the observer design pattern.
+ *  @details    Subscribers register a function and an argument for a named
+ *              topic, and every message published on that topic is handed
+ *              to each of them in the order they subscribed. A topic keeps
+ *              its subscribers in one contiguous array, so publishing is a
+ *              tight loop over function and argument pairs, and
+ *              unsubscribing is `O(1)`. Subscribers may subscribe and
+ *              unsubscribe, themselves included, while a message is being
+ *              published. A bus is not thread-safe.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_macro.h"
+
+
+
+/** @brief      Event bus object.
+ *  @details    This is an opaque `struct`. Please use the provided interface
+ *              to interact with it.
+ */
+typedef struct ezc_event ezc_event;
+
+
+
+/** @brief      Identifies a subscription, see `ezc_event_subscribe`.
+ *  @details    Never `0` for a valid subscription. Handles are not reused,
+ *              so unsubscribing twice is harmless.
+ */
+typedef long ezc_event_handle;
+
+
+
+/** @brief      Create a new event bus without any topics.
+ *  @returns    Pointer to newly allocated event bus.
+ */
+ezc_event* ezc_event_new();
+
+
+
+/** @brief      Free given event buses.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers. All subscriptions are dropped. Do not delete a bus
+ *              while it is publishing.
+ *  @param      self    `ezc_event *` Pointer to an event bus.
+ *  @param      ...     `ezc_event *` Optional pointers to additional event
+ *                      buses to be freed.
+ *  @returns    N/A
+ */
+#define ezc_event_delete(self, ...) \
+    (ezc_event_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_event_delete__(ezc_event *self, ...);
+
+
+
+/** @brief      Call a function for every message published on a topic.
+ *  @details    Subscribing while the topic is being published to takes
+ *              effect from the next message on.
+ *  @param      self    Pointer to an event bus.
+ *  @param      topic   Name of the topic. Copied, so it need not outlive
+ *                      the subscription.
+ *  @param      fn      Pointer to a function. It is passed `arg` followed by
+ *                      the data of the published message.
+ *  @param      arg     Pointer to data that you want passed to `fn`.
+ *  @returns    Handle for `ezc_event_unsubscribe`, or `0` if the
+ *              subscription could not be allocated.
+ */
+ezc_event_handle ezc_event_subscribe(ezc_event *self, char const *topic,
+                                     void (*fn)(void*, void*), void *arg);
+
+
+
+/** @brief      Cancel a subscription.
+ *  @details    Takes effect right away, even if the topic is in the middle of
+ *              being published to.
+ *  @param      self    Pointer to an event bus.
+ *  @param      handle  Handle returned by `ezc_event_subscribe`.
+ *  @returns    `0` on success, or `-1` if there is no such subscription.
+ */
+int ezc_event_unsubscribe(ezc_event *self, ezc_event_handle handle);
+
+
+
+/** @brief      Hand a message to every subscriber of a topic.
+ *  @param      self    Pointer to an event bus.
+ *  @param      topic   Name of the topic.
+ *  @param      data    Pointer to the message, passed to every subscriber.
+ *  @returns    Number of subscribers called.
+ */
+long ezc_event_publish(ezc_event *self, char const *topic, void *data);
+
+
+
+/** @brief      Number of subscribers of a topic.
+ *  @param      self    Pointer to an event bus.
+ *  @param      topic   Name of the topic.
+ *  @returns    Number of subscribers, `0` for unknown topics.
+ */
+long ezc_event_length(ezc_event const *self, char const *topic);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_EVENT_H */
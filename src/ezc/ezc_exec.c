@@ -0,0 +1,506 @@
+/*  ezc_exec.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/* For sysconf despite -std=c89 */
+#define _POSIX_C_SOURCE 200112L
+
+#include "ezc/ezc_exec.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_atomic.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_mem.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/* Capacity of a worker's deque before it first grows. */
+#define EZC_EXEC_MIN_CAPACITY 64
+
+/* How long, in milliseconds, an idle worker sleeps at most before looking
+ * for work again. */
+#define EZC_EXEC_POLL_MS 10
+
+
+
+typedef struct ezc_exec_task
+{
+    void (*fn)(void*);
+    void *arg;
+    ezc_exec_group *group;
+}
+ezc_exec_task;
+
+
+
+/* A worker and its deque, a ring buffer of `capacity` tasks of which
+ * `length` are in use starting at `head`, which is the top. */
+typedef struct ezc_exec_worker
+{
+    pthread_mutex_t lock;
+    ezc_exec_task *tasks;
+    long head, length, capacity;
+
+    pthread_t thread;
+    struct ezc_exec *exec;
+    long index;
+}
+ezc_exec_worker;
+
+
+
+struct ezc_exec
+{
+    ezc_exec_worker *workers;
+    long count;
+
+    /* Tasks waiting in any of the deques */
+    long queued;
+
+    /* Worker that the next task from outside the pool goes to */
+    long next;
+
+    /* Guards sleeping and waking. Workers wait on `work`, and
+     * `ezc_exec_wait` on `done`. */
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    long sleeping;
+    int stopping;
+};
+
+
+
+static pthread_key_t EZC_EXEC_KEY;
+static pthread_once_t EZC_EXEC_ONCE = PTHREAD_ONCE_INIT;
+
+
+
+static void ezc_exec_key_create()
+{
+    pthread_key_create(&EZC_EXEC_KEY, NULL);
+}
+
+
+
+/* The calling thread's worker if it belongs to `self`, else `NULL` */
+static ezc_exec_worker* ezc_exec_worker_get(ezc_exec const *self)
+{
+    ezc_exec_worker *worker;
+
+    pthread_once(&EZC_EXEC_ONCE, ezc_exec_key_create);
+    worker = pthread_getspecific(EZC_EXEC_KEY);
+
+    return (worker != NULL && worker->exec == self ? worker : NULL);
+}
+
+
+
+static void ezc_exec_deadline(struct timespec *deadline, long ms)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    deadline->tv_sec = now.tv_sec + ms / 1000;
+    deadline->tv_nsec = now.tv_usec * 1000L + (ms % 1000) * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+
+
+/* Add a task to the bottom of a deque. Returns `0`, or `-1` if the deque is
+ * full and could not grow. */
+static int ezc_exec_push(ezc_exec_worker *worker, ezc_exec_task task)
+{
+    pthread_mutex_lock(&worker->lock);
+
+    if (worker->length == worker->capacity)
+    {
+        long const CAPACITY = (worker->capacity > 0 ? worker->capacity * 2 :
+                EZC_EXEC_MIN_CAPACITY);
+        ezc_exec_task *tasks;
+        long i;
+
+        EZC_NEWN(tasks, CAPACITY);
+
+        if (tasks == NULL)
+        {
+            pthread_mutex_unlock(&worker->lock);
+            return -1;
+        }
+
+        /* Unwrap the ring while copying */
+        for (i = 0; i < worker->length; i++)
+        {
+            tasks[i] = worker->tasks[(worker->head + i) % worker->capacity];
+        }
+
+        EZC_FREE(worker->tasks);
+        worker->tasks = tasks;
+        worker->head = 0;
+        worker->capacity = CAPACITY;
+    }
+
+    worker->tasks[(worker->head + worker->length) % worker->capacity] = task;
+    worker->length++;
+
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+
+
+/* Take a task from the bottom of a deque, i.e. the newest one, if `bottom`,
+ * else from the top. Returns `0`, or `-1` if the deque is empty. */
+static int ezc_exec_take(ezc_exec_worker *worker, int bottom,
+                         ezc_exec_task *task)
+{
+    int taken = -1;
+
+    pthread_mutex_lock(&worker->lock);
+
+    if (worker->length > 0)
+    {
+        worker->length--;
+
+        if (bottom)
+        {
+            *task = worker->tasks[(worker->head + worker->length) %
+                worker->capacity];
+        }
+        else
+        {
+            *task = worker->tasks[worker->head];
+            worker->head = (worker->head + 1) % worker->capacity;
+        }
+
+        taken = 0;
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return taken;
+}
+
+
+
+/* Find a task, preferring the newest one of our own deque, if any, and else
+ * stealing the oldest one of the next deque that has any. Returns `0`, or
+ * `-1` if there is nothing to do. */
+static int ezc_exec_find(ezc_exec *self, ezc_exec_worker *worker,
+                         ezc_exec_task *task)
+{
+    long const COUNT = EZC_ATOMIC_LOAD(&self->count);
+    long const START = (worker != NULL ? worker->index + 1 :
+            EZC_ATOMIC_LOAD(&self->next));
+    long i;
+
+    if (EZC_ATOMIC_LOAD(&self->queued) == 0) return -1;
+
+    if (worker != NULL && ezc_exec_take(worker, 1, task) == 0)
+    {
+        EZC_ATOMIC_ADD(&self->queued, -1);
+        return 0;
+    }
+
+    for (i = 0; i < COUNT; i++)
+    {
+        ezc_exec_worker * const victim = &self->workers[(START + i) % COUNT];
+
+        if (victim != worker && ezc_exec_take(victim, 0, task) == 0)
+        {
+            EZC_ATOMIC_ADD(&self->queued, -1);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+
+static void ezc_exec_run(ezc_exec *self, ezc_exec_task const *task)
+{
+    (*task->fn)(task->arg);
+
+    /* The last task of a group wakes whoever is waiting for it. Taking the
+     * lock makes sure that waiters are either asleep or yet to check. */
+    if (task->group != NULL && EZC_ATOMIC_ADD(&task->group->pending, -1) == 1)
+    {
+        pthread_mutex_lock(&self->lock);
+        pthread_cond_broadcast(&self->done);
+        pthread_mutex_unlock(&self->lock);
+    }
+}
+
+
+
+static void* ezc_exec_worker_main(void *arg)
+{
+    ezc_exec_worker * const worker = arg;
+    ezc_exec * const self = worker->exec;
+    ezc_exec_task task;
+
+    pthread_once(&EZC_EXEC_ONCE, ezc_exec_key_create);
+    pthread_setspecific(EZC_EXEC_KEY, worker);
+
+    while (1)
+    {
+        struct timespec deadline;
+
+        if (ezc_exec_find(self, worker, &task) == 0)
+        {
+            ezc_exec_run(self, &task);
+            continue;
+        }
+
+        pthread_mutex_lock(&self->lock);
+
+        if (EZC_ATOMIC_LOAD(&self->queued) == 0)
+        {
+            if (self->stopping)
+            {
+                pthread_mutex_unlock(&self->lock);
+                break;
+            }
+
+            /* Submitters only signal when they see us sleeping and never
+             * take the lock first, so a wakeup may be missed. The timeout
+             * bounds the delay in that case. */
+            EZC_ATOMIC_ADD(&self->sleeping, 1);
+            ezc_exec_deadline(&deadline, EZC_EXEC_POLL_MS);
+            pthread_cond_timedwait(&self->work, &self->lock, &deadline);
+            EZC_ATOMIC_ADD(&self->sleeping, -1);
+        }
+
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    return NULL;
+}
+
+
+
+ezc_exec* ezc_exec_new(long workers)
+{
+    ezc_exec *self;
+    long i;
+
+    if (workers <= 0) workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers <= 0) workers = 1;
+
+    EZC_NEW0(self);
+
+    if (self == NULL || (EZC_NEWN(self->workers, workers)) == NULL)
+    {
+        EZC_FREE(self);
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate executor of %li workers.",
+                workers);
+        return NULL;
+    }
+
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_cond_init(&self->work, NULL);
+    pthread_cond_init(&self->done, NULL);
+
+    for (i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&self->workers[i].lock, NULL);
+        self->workers[i].exec = self;
+        self->workers[i].index = i;
+    }
+
+    /* Only the first `count` deques are ever pushed to */
+    self->count = workers;
+
+    for (i = 0; i < workers; i++)
+    {
+        if (pthread_create(&self->workers[i].thread, NULL,
+                    ezc_exec_worker_main, &self->workers[i]) != 0)
+        {
+            ezc_log(EZC_LOG_WARN, "Unable to start worker #%li of %li.", i,
+                    workers);
+            EZC_ATOMIC_STORE(&self->count, i);
+            break;
+        }
+    }
+
+    if (self->count == 0)
+    {
+        ezc_exec_delete(self);
+    }
+
+    return self;
+}
+
+
+
+void ezc_exec_delete__(ezc_exec *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        long i;
+
+        pthread_mutex_lock(&self->lock);
+        self->stopping = 1;
+        pthread_cond_broadcast(&self->work);
+        pthread_mutex_unlock(&self->lock);
+
+        for (i = 0; i < self->count; i++)
+        {
+            pthread_join(self->workers[i].thread, NULL);
+        }
+
+        /* Deques are empty now that every worker has seen `queued == 0` */
+        for (i = 0; i < self->count; i++)
+        {
+            pthread_mutex_destroy(&self->workers[i].lock);
+            EZC_FREE(self->workers[i].tasks);
+        }
+
+        pthread_cond_destroy(&self->done);
+        pthread_cond_destroy(&self->work);
+        pthread_mutex_destroy(&self->lock);
+        EZC_FREE(self->workers);
+        EZC_FREE(self);
+
+        self = va_arg(arg_ptr, ezc_exec*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+/* Queue `fn(arg)`, or run it right away if that fails */
+static void ezc_exec_post(ezc_exec *self, ezc_exec_group *group,
+                          void (*fn)(void*), void *arg)
+{
+    assert(self != NULL && fn != NULL);
+
+    ezc_exec_worker *worker = ezc_exec_worker_get(self);
+    ezc_exec_task task;
+
+    task.fn = fn;
+    task.arg = arg;
+    task.group = group;
+
+    if (group != NULL) EZC_ATOMIC_ADD(&group->pending, 1);
+
+    if (worker == NULL)
+    {
+        worker = &self->workers[(unsigned long)
+            EZC_ATOMIC_ADD(&self->next, 1) % EZC_ATOMIC_LOAD(&self->count)];
+    }
+
+    /* Count it first, so that `queued` never falls behind the deques */
+    EZC_ATOMIC_ADD(&self->queued, 1);
+
+    if (ezc_exec_push(worker, task) != 0)
+    {
+        EZC_ATOMIC_ADD(&self->queued, -1);
+        ezc_log(EZC_LOG_WARN, "Unable to queue task. Running it right away.");
+        ezc_exec_run(self, &task);
+        return;
+    }
+
+    if (EZC_ATOMIC_LOAD(&self->sleeping) > 0)
+    {
+        pthread_cond_signal(&self->work);
+    }
+}
+
+
+
+/* `ezc_callback_call` as a task function */
+static void ezc_exec_call(void *callback)
+{
+    ezc_callback_call(callback);
+}
+
+
+
+void ezc_exec_submit(ezc_exec *self, ezc_exec_group *group,
+                     ezc_callback const *callback)
+{
+    ezc_exec_post(self, group, ezc_exec_call, (void *) callback);
+}
+
+
+
+void ezc_exec_wait(ezc_exec *self, ezc_exec_group *group)
+{
+    assert(self != NULL && group != NULL);
+
+    ezc_exec_worker * const worker = ezc_exec_worker_get(self);
+    ezc_exec_task task;
+
+    while (EZC_ATOMIC_LOAD(&group->pending) > 0)
+    {
+        struct timespec deadline;
+
+        /* Help out rather than block a worker */
+        if (ezc_exec_find(self, worker, &task) == 0)
+        {
+            ezc_exec_run(self, &task);
+            continue;
+        }
+
+        /* Nothing to help with right now. The rest is either running
+         * elsewhere or yet to be submitted by what is running, in which
+         * case only the timeout wakes us up to help again. */
+        pthread_mutex_lock(&self->lock);
+
+        if (EZC_ATOMIC_LOAD(&group->pending) > 0)
+        {
+            ezc_exec_deadline(&deadline, EZC_EXEC_POLL_MS);
+            pthread_cond_timedwait(&self->done, &self->lock, &deadline);
+        }
+
+        pthread_mutex_unlock(&self->lock);
+    }
+}
+
+
+
+void ezc_exec_map__(ezc_exec *self, ezc_list const *list, void (*fn)(void*))
+{
+    ezc_exec_group group = { 0 };
+
+    while (list != NULL)
+    {
+        ezc_exec_post(self, &group, fn, list->data);
+        list = list->next;
+    }
+
+    ezc_exec_wait(self, &group);
+}
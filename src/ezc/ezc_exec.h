@@ -0,0 +1,145 @@
+/*  ezc_exec.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_EXEC_H
+#define EZC_EXEC_H
+
+/** @file       ezc_exec.h
+ *  @brief      Thread pool that runs callbacks in parallel.
+ *  @details    An executor owns a fixed number of worker threads, each with
+ *              a deque of its own. Callbacks submitted from a worker go to
+ *              the bottom of its deque and are run newest first, while
+ *              idle workers steal the oldest callbacks from the top of the
+ *              others' deques. Callbacks submitted from any other thread
+ *              are spread over the workers in turn. Wait groups tell when a
+ *              batch of callbacks is done.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_callback.h"
+#include "ezc/ezc_list.h"
+#include "ezc/ezc_macro.h"
+
+
+
+/** @brief      Executor object.
+ *  @details    This is an opaque `struct`. Please use the provided interface
+ *              to interact with it.
+ */
+typedef struct ezc_exec ezc_exec;
+
+
+
+/** @brief      Counts callbacks that have been submitted but not yet run.
+ *  @details    Zero-initialize it, e.g. `ezc_exec_group group = { 0 };`,
+ *              pass it along with every callback of a batch, then wait for
+ *              it with `ezc_exec_wait`. May be reused once waited for.
+ */
+typedef struct ezc_exec_group
+{
+    /** Number of callbacks still to run. Only read it atomically. */
+    long pending;
+}
+ezc_exec_group;
+
+
+
+/** @brief      Create a new executor and start its worker threads.
+ *  @param      workers Number of worker threads. `0` or less for one per
+ *                      online processor.
+ *  @returns    Pointer to newly allocated executor, or `NULL` if no worker
+ *              could be started.
+ */
+ezc_exec* ezc_exec_new(long workers);
+
+
+
+/** @brief      Free given executors.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers. Runs every callback still pending, including those
+ *              they submit, then stops the workers. Do not submit from
+ *              other threads while deleting.
+ *  @param      self    `ezc_exec *` Pointer to an executor.
+ *  @param      ...     `ezc_exec *` Optional pointers to additional executors
+ *                      to be freed.
+ *  @returns    N/A
+ */
+#define ezc_exec_delete(self, ...) \
+    (ezc_exec_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_exec_delete__(ezc_exec *self, ...);
+
+
+
+/** @brief      Run a callback on one of the workers.
+ *  @details    The callback is not copied, so it must stay alive until it
+ *              has run. If the executor cannot make room for it, the
+ *              callback runs right away on the calling thread instead.
+ *  @param      self        Pointer to an executor.
+ *  @param      group       Wait group to count the callback in, or `NULL`.
+ *  @param      callback    Pointer to a callback object.
+ */
+void ezc_exec_submit(ezc_exec *self, ezc_exec_group *group,
+                     ezc_callback const *callback);
+
+
+
+/** @brief      Wait until every callback counted in a group has run.
+ *  @details    Rather than only sleeping, the calling thread runs pending
+ *              callbacks itself while it waits. Waiting from within a
+ *              callback is therefore fine and does not tie up a worker.
+ *  @param      self    Pointer to an executor.
+ *  @param      group   Wait group to wait for.
+ */
+void ezc_exec_wait(ezc_exec *self, ezc_exec_group *group);
+
+
+
+/** @brief      Apply function to each item of list, in parallel.
+ *  @details    The parallel counterpart of `ezc_list_map`, e.g.
+ *              `ezc_exec_map(exec, images, blur);` given
+ *              `void blur(void *image)`. Items are visited in no particular
+ *              order. Returns once `fn` has returned for every item. Do not
+ *              modify the list meanwhile. For a list of callback objects,
+ *              hand each to `ezc_exec_submit` instead.
+ *  @param      self    `ezc_exec *` Pointer to an executor.
+ *  @param      list    `ezc_list const *` Pointer to a list.
+ *  @param      fn      Pointer to a function. The function must accept an
+ *                      item's data as its only argument.
+ *  @returns    N/A
+ */
+#define ezc_exec_map(self, list, fn) \
+    (ezc_exec_map__((self), (list), (void (*)(void*)) (fn)))
+
+void ezc_exec_map__(ezc_exec *self, ezc_list const *list, void (*fn)(void*));
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_EXEC_H */
@@ -27,6 +27,53 @@
 #include "ezc/ezc_mem.h"
 #include <limits.h>
 #include <stdarg.h>
+#include <stddef.h>
+
+
+
+/* Item pool shared by every list, made on first use. Deleted by
+ * `ezc_list_pool_trim` once no item is alive anymore. */
+static ezc_mem_pool *EZC_LIST_POOL = NULL;
+static long EZC_LIST_LIVE = 0;
+
+
+
+static ezc_list* ezc_list_alloc()
+{
+    ezc_mem_pool *pool = EZC_ATOMIC_LOAD(&EZC_LIST_POOL);
+    ezc_list *item;
+
+    /* Whoever loses the race to create the pool throws theirs away */
+    if (pool == NULL)
+    {
+        pool = ezc_mem_pool_new(sizeof *item);
+        EZC_MEM_KEEP(pool);
+
+        if (pool != NULL && !EZC_ATOMIC_CAS(&EZC_LIST_POOL, NULL, pool))
+        {
+            ezc_mem_pool_delete(pool);
+            pool = EZC_ATOMIC_LOAD(&EZC_LIST_POOL);
+        }
+
+        if (pool == NULL) return NULL;
+    }
+
+    item = ezc_mem_pool_alloc(pool);
+    if (item != NULL) EZC_ATOMIC_ADD(&EZC_LIST_LIVE, 1);
+
+    return item;
+}
+
+
+
+/* Hand an entire chain back to the pool at once. */
+static void ezc_list_release(ezc_list *head)
+{
+    long const LENGTH = ezc_mem_pool_free_chain(
+            EZC_ATOMIC_LOAD(&EZC_LIST_POOL), head, offsetof(ezc_list, next));
+
+    EZC_ATOMIC_ADD(&EZC_LIST_LIVE, -LENGTH);
+}
 
 
 
@@ -35,13 +82,22 @@ ezc_list* ezc_list_new__(void const *data, ...)
     va_list arg_ptr;
     va_start(arg_ptr, data);
 
-    ezc_list * const head = NULL;
+    ezc_list *head = NULL;
     ezc_list **iter = &head;
 
     while (data != NULL)
     {
         /* Initialize this item and append to list */
-        EZC_NEW(*iter);
+        *iter = ezc_list_alloc();
+
+        if (*iter == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Could not allocate list item.");
+            ezc_list_delete(head);
+            va_end(arg_ptr);
+            return NULL;
+        }
+
         (*iter)->data = data;
 
         /* Increment iterator and data args */
@@ -58,12 +114,20 @@ ezc_list* ezc_list_new__(void const *data, ...)
 
 ezc_list* ezc_list_copy__(ezc_list const *orig)
 {
-    ezc_list * const head = NULL;
+    ezc_list *head = NULL;
     ezc_list **iter = &head;
 
     while (orig != NULL)
     {
-        EZC_NEW(*iter);
+        *iter = ezc_list_alloc();
+
+        if (*iter == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Could not allocate list item.");
+            ezc_list_delete(head);
+            return NULL;
+        }
+
         (*iter)->data = orig->data;
 
         iter = &(*iter)->next;
@@ -101,17 +165,20 @@ ezc_list* ezc_list_cat__(ezc_list *self, ...)
     va_start(arg_ptr, self);
 
     ezc_list * const head = self;
-    ezc_list *prev;
+    ezc_list *prev, *next;
 
-    while(self != NULL)
+    /* Stop before the last list so that it is never walked needlessly */
+    while (self != NULL && (next = va_arg(arg_ptr, ezc_list*)) != NULL)
     {
         prev = self;
-        self = va_arg(arg_ptr, ezc_list*);
 
         while (prev->next != NULL) prev = prev->next;
-        prev->next = self;
+        prev->next = next;
+
+        self = next;
     }
 
+    va_end(arg_ptr);
     return head;
 }
 
@@ -124,16 +191,22 @@ void ezc_list_delete__(ezc_list *self, ...)
 
     while (self != NULL)
     {
-        ezc_list *iter = self, *temp;
+        ezc_list_release(self);
+        self = va_arg(arg_ptr, ezc_list*);
+    }
 
-        while (iter != NULL)
-        {
-            temp = iter->next;
-            EZC_FREE(iter);
-            iter = temp;
-        }
+    va_end(arg_ptr);
+}
 
-        self = va_arg(arg_ptr, ezc_list*);
+
+
+void ezc_list_pool_trim()
+{
+    if (EZC_ATOMIC_LOAD(&EZC_LIST_LIVE) == 0)
+    {
+        ezc_mem_pool *pool = EZC_ATOMIC_EXCHANGE(&EZC_LIST_POOL,
+                (ezc_mem_pool *) NULL);
+        ezc_mem_pool_delete(pool);
     }
 }
 
@@ -223,15 +296,27 @@ void ezc_list_push_at__(ezc_list *self, long n, ...)
     va_start(arg_ptr, n);
 
     void *data;
-    ezc_list *data_list = NULL;
+    ezc_list *data_list = NULL, **data_iter = &data_list;
 
     /* Get all data out of arg_ptr */
     while ((data = va_arg(arg_ptr, void const *)) != NULL)
     {
-        if (data_list == NULL) data_list = ezc_list_new(data);
-        else ezc_list_cat(data_list, ezc_list_new(data));
+        *data_iter = ezc_list_alloc();
+
+        if (*data_iter == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Could not allocate list item.");
+            ezc_list_delete(data_list);
+            va_end(arg_ptr);
+            return;
+        }
+
+        (*data_iter)->data = data;
+        data_iter = &(*data_iter)->next;
     }
 
+    *data_iter = NULL;
+
     /* Now actually add it to self */
     if (data_list != NULL)
     {
@@ -301,3 +386,246 @@ ezc_list* ezc_list_pop_match_fn__(ezc_list const *self,
 
     return popped;
 }
+
+
+
+/* A fresh item for a handle, from its arena if it has one. */
+static ezc_list* ezc_list_handle_alloc(ezc_list_handle const *self,
+                                       void const *data)
+{
+    ezc_list *item;
+
+    if (self->arena != NULL) EZC_ARENA_NEW(self->arena, item);
+    else item = ezc_list_alloc();
+
+    if (item == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate list item.");
+        return NULL;
+    }
+
+    item->data = (void *) data;
+    item->next = NULL;
+
+    return item;
+}
+
+
+
+/* Chain up items for `data` and the arguments after it, stopping at `NULL`.
+ * Returns the number of items, or -1, leaving nothing allocated behind, if
+ * any of them could not be allocated. */
+static long ezc_list_handle_chain(ezc_list_handle const *self,
+                                  void const *data, va_list arg_ptr,
+                                  ezc_list **head, ezc_list **tail)
+{
+    long length = 0;
+
+    *head = *tail = NULL;
+
+    while (data != NULL)
+    {
+        ezc_list *item = ezc_list_handle_alloc(self, data);
+
+        if (item == NULL)
+        {
+            /* Arena items go along with the arena */
+            if (self->arena == NULL) ezc_list_release(*head);
+            *head = *tail = NULL;
+            return -1;
+        }
+
+        if (*tail == NULL) *head = item;
+        else (*tail)->next = item;
+
+        *tail = item;
+        length++;
+
+        data = va_arg(arg_ptr, void const *);
+    }
+
+    return length;
+}
+
+
+
+/* Returns 0 if an item could not be allocated. */
+static int ezc_list_handle_init(ezc_list_handle *self, ezc_arena *arena,
+                                void const *data, va_list arg_ptr)
+{
+    self->arena = arena;
+    self->length = ezc_list_handle_chain(self, data, arg_ptr, &self->head,
+            &self->tail);
+
+    return self->length >= 0;
+}
+
+
+
+ezc_list_handle* ezc_list_handle_new__(void const *data, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, data);
+
+    ezc_list_handle *self;
+    EZC_NEW(self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate list handle.");
+    }
+    else if (!ezc_list_handle_init(self, NULL, data, arg_ptr))
+    {
+        EZC_FREE(self);
+    }
+
+    va_end(arg_ptr);
+    return self;
+}
+
+
+
+ezc_list_handle* ezc_list_handle_new_arena__(ezc_arena *arena, ...)
+{
+    assert(arena != NULL);
+
+    va_list arg_ptr;
+    va_start(arg_ptr, arena);
+
+    ezc_list_handle *self;
+    EZC_ARENA_NEW(arena, self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate list handle.");
+    }
+    else if (!ezc_list_handle_init(self, arena,
+                va_arg(arg_ptr, void const *), arg_ptr))
+    {
+        /* Freed along with the arena */
+        self = NULL;
+    }
+
+    va_end(arg_ptr);
+    return self;
+}
+
+
+
+void ezc_list_handle_delete__(ezc_list_handle *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        /* Arena handles are freed along with their arena */
+        if (self->arena == NULL)
+        {
+            if (self->head != NULL) ezc_list_release(self->head);
+            EZC_FREE(self);
+        }
+
+        self = va_arg(arg_ptr, ezc_list_handle*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_list_handle_push_front__(ezc_list_handle *self, ...)
+{
+    assert(self != NULL);
+
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    ezc_list *head, *tail;
+    long const LENGTH = ezc_list_handle_chain(self,
+            va_arg(arg_ptr, void const *), arg_ptr, &head, &tail);
+
+    /* Prepend in one go so the pushed items keep their argument order */
+    if (LENGTH > 0)
+    {
+        tail->next = self->head;
+        self->head = head;
+        if (self->tail == NULL) self->tail = tail;
+        self->length += LENGTH;
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_list_handle_push_back__(ezc_list_handle *self, ...)
+{
+    assert(self != NULL);
+
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    ezc_list *head, *tail;
+    long const LENGTH = ezc_list_handle_chain(self,
+            va_arg(arg_ptr, void const *), arg_ptr, &head, &tail);
+
+    if (LENGTH > 0)
+    {
+        if (self->tail == NULL) self->head = head;
+        else self->tail->next = head;
+
+        self->tail = tail;
+        self->length += LENGTH;
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+ezc_list* ezc_list_handle_pop_front__(ezc_list_handle *self)
+{
+    assert(self != NULL);
+
+    ezc_list *popped = self->head;
+
+    if (popped != NULL)
+    {
+        self->head = popped->next;
+        if (self->head == NULL) self->tail = NULL;
+        self->length--;
+
+        popped->next = NULL;
+    }
+
+    return popped;
+}
+
+
+
+void ezc_list_handle_erase_front__(ezc_list_handle *self)
+{
+    ezc_list * const popped = ezc_list_handle_pop_front__(self);
+
+    if (popped != NULL && self->arena == NULL) ezc_list_release(popped);
+}
+
+
+
+void ezc_list_handle_sync__(ezc_list_handle *self)
+{
+    assert(self != NULL);
+
+    ezc_list *iter = self->head;
+
+    self->tail = NULL;
+    self->length = 0;
+
+    while (iter != NULL)
+    {
+        self->tail = iter;
+        self->length++;
+        iter = iter->next;
+    }
+}
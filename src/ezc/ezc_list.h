@@ -25,9 +25,15 @@
 /** @file       ezc_list.h
  *  @brief      Featureful singly linked list implementation.
  *  @details    The included functions and macros allow for this module to be
- *              used like a stack, queue, or vector. Note to Contributors: I've
- *              found that when implementing macros, it is best to have the
- *              macros use the actual functions themselves.
+ *              used like a stack, queue, or vector. Items are not allocated
+ *              one `malloc` at a time but handed out of a pool shared by
+ *              every list, see `ezc_mem_pool`, so lists may be made and
+ *              deleted by any thread. The pool's slabs come from the global
+ *              allocator at the time the pool is made, see
+ *              `ezc_mem_pool_new`, since lists take no allocator of their
+ *              own. See also `ezc_list_pool_trim`. Note to
+ *              Contributors: I've found that when implementing macros, it is
+ *              best to have the macros use the actual functions themselves.
  */
 
 #ifdef __cplusplus
@@ -35,7 +41,11 @@ extern C
 {
 #endif
 
+#include "ezc/ezc_arena.h"
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_atomic.h"
 #include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
 #include <stdarg.h>
 #include <stddef.h>
 
@@ -123,7 +133,9 @@ ezc_list* ezc_list_cat__(ezc_list *self, ...);
 
 /** @brief      Free given lists.
  *  @details    Free the memory holding the lists. Also set the pointers to
- *              equal `NULL` to help prevent dangling pointers.
+ *              equal `NULL` to help prevent dangling pointers. Each list is
+ *              handed back to the item pool as a whole rather than item by
+ *              item. Items must never be passed to `free` directly.
  *  @param      self    `ezc_list *` Pointer to a list.
  *  @param      ...     `ezc_list *` Optional pointers to additional lists to
  *                      be freed.
@@ -131,12 +143,24 @@ ezc_list* ezc_list_cat__(ezc_list *self, ...);
  */
 #define ezc_list_delete(self, ...) \
     (ezc_list_delete__((self), ##__VA_ARGS__, NULL), \
-     SST_MAP(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
 
 void ezc_list_delete__(ezc_list *self, ...);
 
 
 
+/** @brief      Release pooled item memory back to the system.
+ *  @details    Deleted items are kept around for reuse by later lists. Once
+ *              every list has been deleted, this function frees the pool.
+ *              It does nothing while any item is still in use. No other
+ *              thread may make or delete lists while this runs. The next
+ *              list made gets a new pool.
+ *  @returns    N/A
+ */
+void ezc_list_pool_trim();
+
+
+
 /** @brief      Length of list.
  *  @details    The use of signed `long` is encouraged so that overflow is
  *              easier to detect.
@@ -299,9 +323,9 @@ void ezc_list_push_at__(ezc_list *self, long n, ...);
  *  @param      n       `long` The index of the item you want to be popped.
  *  @returns    `ezc_list *` Pointer to the item that got popped. Note: no
  *              memory is freed by this function. It is your responsability
- *              to free the popped item. Consider using `ezc_list_erase_at` if
- *              you don't want to worry about freeing memory yourself. Returns
- *              `NULL` if any problems occured.
+ *              to free the popped item via `ezc_list_delete`. Consider using
+ *              `ezc_list_erase_at` if you don't want to worry about freeing
+ *              memory yourself. Returns `NULL` if any problems occured.
  */
 #define ezc_list_pop_at(self, n) \
     (ezc_list_pop_at__(&(self), (n)))
@@ -436,6 +460,344 @@ ezc_list* ezc_list_pop_match_fn__(ezc_list const *self,
     (ezc_list_delete__(ezc_list_pop_match_fn__((self), (neq), (data)), NULL))
 
 
+/** @brief      List handle structure.
+ *  @details    Wraps a list and keeps track of its tail and length so that
+ *              appending, popping the front and getting the length are all
+ *              `O(1)`. The wrapped list in `head` is a plain `ezc_list`, so
+ *              any of the non-mutating functions above, such as
+ *              `ezc_list_map` or `ezc_list_get_match`, can be used on it
+ *              directly. If you modify `head` yourself, call
+ *              `ezc_list_handle_sync` afterwards.
+ */
+typedef struct ezc_list_handle
+{
+    /** First item of the wrapped list. `NULL` when empty. */
+    ezc_list *head;
+
+    /** Last item of the wrapped list. `NULL` when empty. */
+    ezc_list *tail;
+
+    /** Number of items in the wrapped list. */
+    long length;
+
+    /** Arena that the handle and its items come from, or `NULL`. */
+    ezc_arena *arena;
+}
+ezc_list_handle;
+
+
+
+/** @brief      Initialize a list handle.
+ *  @details    Unlike `ezc_list_new`, blank handles are allowed, i.e.
+ *              `ezc_list_handle_new(NULL)`. Otherwise populate the list just
+ *              like you would with `ezc_list_new`. Items come from the same
+ *              pool as those of `ezc_list`, while the handle itself is
+ *              allocated via the global allocator, see `ezc_mem_allocator`,
+ *              which must not change before the handle is deleted. For
+ *              memory of your own choosing use `ezc_list_handle_new_arena`.
+ *  @param      self    `void const *` First item of the list, or `NULL`.
+ *  @param      ...     `void const *` Optional additional list item arguments.
+ *  @returns    `ezc_list_handle *` Pointer to allocated handle, or `NULL` if
+ *              the handle or any of its items could not be allocated.
+ */
+#define ezc_list_handle_new(self, ...) \
+    (ezc_list_handle_new__((self), ##__VA_ARGS__, NULL))
+
+ezc_list_handle* ezc_list_handle_new__(void const *data, ...);
+
+
+
+/** @brief      Initialize a list handle whose items come from an arena.
+ *  @details    Works just like `ezc_list_handle_new`, except that the handle
+ *              and every item pushed to it are allocated from `arena`.
+ *              Deleting the handle or erasing its items frees nothing:
+ *              everything is freed along with the arena instead, in one go.
+ *              Never hand its items to the regular `ezc_list` functions that
+ *              free or allocate items.
+ *  @param      arena   `ezc_arena *` Arena to allocate from.
+ *  @param      ...     `void const *` Optional list item arguments.
+ *  @returns    `ezc_list_handle *` Pointer to allocated handle, or `NULL` if
+ *              the handle or any of its items could not be allocated.
+ */
+#define ezc_list_handle_new_arena(arena, ...) \
+    (ezc_list_handle_new_arena__((arena), ##__VA_ARGS__, NULL))
+
+ezc_list_handle* ezc_list_handle_new_arena__(ezc_arena *arena, ...);
+
+
+
+/** @brief      Free given list handles and the lists they wrap.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @param      ...     `ezc_list_handle *` Optional pointers to additional
+ *                      list handles to be freed.
+ *  @returns    N/A
+ */
+#define ezc_list_handle_delete(self, ...) \
+    (ezc_list_handle_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_list_handle_delete__(ezc_list_handle *self, ...);
+
+
+
+/** @brief      Length of wrapped list.
+ *  @details    `O(1)` counterpart of `ezc_list_length`.
+ *  @param      self    `ezc_list_handle const *` Pointer to a list handle.
+ *  @returns    `long` Length of the wrapped list.
+ */
+#define ezc_list_handle_length(self) \
+    ((self)->length)
+
+
+
+/** @brief      Push items to the front.
+ *  @details    If any item cannot be allocated, none are pushed.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @param      ...     `void const *` Data you want to be pushed to the list.
+ *                      Provide as many as you want.
+ *  @returns    N/A
+ */
+#define ezc_list_handle_push_front(self, ...) \
+    (ezc_list_handle_push_front__((self), ##__VA_ARGS__, NULL))
+
+void ezc_list_handle_push_front__(ezc_list_handle *self, ...);
+
+
+
+/** @brief      Push items to the back.
+ *  @details    `O(1)` per item counterpart of `ezc_list_push_back`. If any
+ *              item cannot be allocated, none are pushed.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @param      ...     `void const *` Data you want to be pushed to the list.
+ *                      Provide as many as you want.
+ *  @returns    N/A
+ */
+#define ezc_list_handle_push_back(self, ...) \
+    (ezc_list_handle_push_back__((self), ##__VA_ARGS__, NULL))
+
+void ezc_list_handle_push_back__(ezc_list_handle *self, ...);
+
+
+
+/** @brief      Pop first item.
+ *  @details    `O(1)` counterpart of `ezc_list_pop_front`.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @returns    `ezc_list *` Pointer to the item that got popped. See
+ *              `ezc_list_pop_at` documentation for more details. Returns
+ *              `NULL` if the list was empty. Items of handles made by
+ *              `ezc_list_handle_new_arena` belong to the arena, so do not
+ *              delete them.
+ */
+#define ezc_list_handle_pop_front(self) \
+    (ezc_list_handle_pop_front__((self)))
+
+ezc_list* ezc_list_handle_pop_front__(ezc_list_handle *self);
+
+
+
+/** @brief      Erase first item.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @returns    N/A
+ */
+#define ezc_list_handle_erase_front(self) \
+    (ezc_list_handle_erase_front__((self)))
+
+void ezc_list_handle_erase_front__(ezc_list_handle *self);
+
+
+
+/** @brief      Recompute tail and length of wrapped list.
+ *  @details    This is `O(n)`. Only needed after modifying `self->head`
+ *              through the regular `ezc_list` functions.
+ *  @param      self    `ezc_list_handle *` Pointer to a list handle.
+ *  @returns    N/A
+ */
+#define ezc_list_handle_sync(self) \
+    (ezc_list_handle_sync__((self)))
+
+void ezc_list_handle_sync__(ezc_list_handle *self);
+
+
+
+/** @brief      Declare a list type that stores items of the given type.
+ *  @details    `ezc_list` items store pointers, so storing numbers or small
+ *              structures takes an extra allocation per item and a detour on
+ *              each access. Items of lists declared by this macro store the
+ *              data itself. For example, `EZC_LIST_DECLARE(int_list, int)`
+ *              declares the item type `int_list`, whose members are `data`
+ *              and `next`, along with these functions, which work just like
+ *              their `ezc_list` counterparts:
+ *              - `int_list* int_list_new(int data)`
+ *              - `void int_list_delete(int_list *self)`
+ *              - `long int_list_length(int_list const *self)`
+ *              - `int_list* int_list_get_at(int_list const *self, long n)`
+ *              - `int_list* int_list_push_at(int_list **self, long n,
+ *                                            int data)`
+ *              - `int_list* int_list_push_front(int_list **self, int data)`
+ *              - `int_list* int_list_push_back(int_list **self, int data)`
+ *              - `int_list* int_list_pop_at(int_list **self, long n)`
+ *              - `void int_list_erase_at(int_list **self, long n)`
+ *              - `void int_list_pool_delete()`
+ *
+ *              Like with `ezc_list`, `NULL` is the empty list. Pushing
+ *              returns the pushed item, or `NULL` if it could not be
+ *              allocated. Items of each list type come from one pool, see
+ *              `ezc_mem_pool`, which is made on first use and lives in the
+ *              translation unit that uses `EZC_LIST_DEFINE`. So put this
+ *              macro in a header and `EZC_LIST_DEFINE` in exactly one source
+ *              file, after which items may be made in one file and deleted
+ *              in another. Functions a file does not call cause no warnings.
+ *
+ *              The items do not know where the list ends, so
+ *              `int_list_push_back` walks the whole list and is `O(n)`. To
+ *              append many items, keep the last one and push in front of
+ *              its `next` instead, which is `O(1)`:
+ *              `last = int_list_push_front(&last->next, data)`.
+ *  @param      name    Name of the list item type.
+ *  @param      type    Type of the items' data.
+ */
+#define EZC_LIST_DECLARE(name, type) \
+    typedef struct name \
+    { \
+        type data; \
+        struct name *next; \
+    } \
+    name; \
+    \
+    extern ezc_mem_pool *name##_pool__; \
+    \
+    void name##_pool_delete(); \
+    \
+    static EZC_UNUSED name* name##_item__(type data, name *next) \
+    { \
+        ezc_mem_pool *pool = EZC_ATOMIC_LOAD(&name##_pool__); \
+        name *item; \
+        \
+        /* Whoever loses the race to create the pool throws theirs away */ \
+        if (pool == NULL) \
+        { \
+            pool = ezc_mem_pool_new(sizeof *item); \
+            \
+            if (pool != NULL && !EZC_ATOMIC_CAS(&name##_pool__, NULL, pool)) \
+            { \
+                ezc_mem_pool_delete(pool); \
+                pool = EZC_ATOMIC_LOAD(&name##_pool__); \
+            } \
+            \
+            if (pool == NULL) return NULL; \
+        } \
+        \
+        item = ezc_mem_pool_alloc(pool); \
+        \
+        if (item != NULL) \
+        { \
+            item->data = data; \
+            item->next = next; \
+        } \
+        \
+        return item; \
+    } \
+    \
+    static EZC_UNUSED name* name##_new(type data) \
+    { \
+        return name##_item__(data, NULL); \
+    } \
+    \
+    static EZC_UNUSED void name##_delete(name *self) \
+    { \
+        while (self != NULL) \
+        { \
+            name * const next = self->next; \
+            ezc_mem_pool_free(EZC_ATOMIC_LOAD(&name##_pool__), self); \
+            self = next; \
+        } \
+    } \
+    \
+    static EZC_UNUSED long name##_length(name const *self) \
+    { \
+        long length = 0; \
+        \
+        for (; self != NULL; self = self->next) length++; \
+        return length; \
+    } \
+    \
+    static EZC_UNUSED name* name##_get_at(name const *self, long n) \
+    { \
+        assert(n >= 0 && n < name##_length(self)); \
+        \
+        while (n-- > 0 && self != NULL) self = self->next; \
+        return (name *) self; \
+    } \
+    \
+    static EZC_UNUSED name* name##_push_at(name **self, long n, type data) \
+    { \
+        assert(self != NULL && n >= 0 && n <= name##_length(*self)); \
+        \
+        while (n-- > 0 && *self != NULL) self = &(*self)->next; \
+        \
+        { \
+            name * const item = name##_item__(data, *self); \
+            if (item != NULL) *self = item; \
+            return item; \
+        } \
+    } \
+    \
+    static EZC_UNUSED name* name##_push_front(name **self, type data) \
+    { \
+        return name##_push_at(self, 0, data); \
+    } \
+    \
+    static EZC_UNUSED name* name##_push_back(name **self, type data) \
+    { \
+        while (*self != NULL) self = &(*self)->next; \
+        return name##_push_at(self, 0, data); \
+    } \
+    \
+    static EZC_UNUSED name* name##_pop_at(name **self, long n) \
+    { \
+        name *popped; \
+        \
+        assert(self != NULL && n >= 0 && n < name##_length(*self)); \
+        \
+        while (n-- > 0 && *self != NULL) self = &(*self)->next; \
+        \
+        popped = *self; \
+        if (popped != NULL) \
+        { \
+            *self = popped->next; \
+            popped->next = NULL; \
+        } \
+        \
+        return popped; \
+    } \
+    \
+    static EZC_UNUSED void name##_erase_at(name **self, long n) \
+    { \
+        name##_delete(name##_pop_at(self, n)); \
+    }
+
+
+
+/** @brief      Define the pool of a list type declared by `EZC_LIST_DECLARE`.
+ *  @details    Use in exactly one source file. This also defines
+ *              `name##_pool_delete`, which frees the pool along with every
+ *              item still in it. Call it once no thread uses the list type
+ *              anymore. The pool gets made again if items are pushed later.
+ *  @param      name    Name of the list item type.
+ */
+#define EZC_LIST_DEFINE(name) \
+    ezc_mem_pool *name##_pool__ = NULL; \
+    \
+    void name##_pool_delete() \
+    { \
+        ezc_mem_pool *pool = EZC_ATOMIC_EXCHANGE(&name##_pool__, \
+                (ezc_mem_pool *) NULL); \
+        ezc_mem_pool_delete(pool); \
+    }
+
+
 
 #ifdef __cplusplus
 }
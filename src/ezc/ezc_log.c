@@ -19,168 +19,2912 @@
  *  3. This notice may not be removed or altered from any source distribution.
  */
 
+/* For snprintf, fsync and friends despite -std=c89 */
+#define _POSIX_C_SOURCE 200112L
+
 #include "ezc/ezc_log.h"
 
-#include "ezc/ezc_list.h"
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_atomic.h"
 #include "ezc/ezc_mem.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
+
+
+
+/* Longest message, including its header, that a single log can hold. */
+#define EZC_LOG_BUFFER_SIZE 4096
+
+/* Record budget of each thread's log unless `ezc_log_capacity` says
+ * otherwise. */
+#define EZC_LOG_DEFAULT_RECORDS 4096
+
+/* How long, in milliseconds, the writer thread and `ezc_log_flush` sleep at
+ * most before checking on the queue again. */
+#define EZC_LOG_POLL_MS 10
+
+/* Longest line, including its newline, that a record encodes to in JSON. */
+#define EZC_LOG_JSON_SIZE (8 * EZC_LOG_BUFFER_SIZE)
+
+/* Records up to this size, text or arguments included, come from a pool
+ * unless a different allocator was set. Most messages are much shorter. */
+#define EZC_LOG_POOLED_SIZE 256
 
+/* Size of the stdio buffer of buffered log files. */
+#define EZC_LOG_FILE_BUFFER 65536
 
+/* Identifies files written by `ezc_log_dump`. */
+#define EZC_LOG_DUMP_MAGIC "EZCLOG1\n"
+
+/* Longest file name or format string in a dump. Longer ones get cut short, so
+ * that decoding can reject records whose lengths make no sense. */
+#define EZC_LOG_DUMP_STRING 4096
+
+/* Number of call sites that can be rate limited, a power of two. Sites past
+ * that are never limited. */
+#define EZC_LOG_SITES 4096
 
-static ezc_list *EZC_LOG_LIST = NULL;
-static long const EZC_LOG_BUFFER_SIZE = 4092;
 static FILE *EZC_LOG_ECHO_DEST = NULL;
+static ezc_log_mode_t EZC_LOG_MODE = EZC_LOG_MODE_TEXT;
+
+ezc_log_t ezc_log_level__ = EZC_LOG_INFO;
+long ezc_log_rate__ = 0;
+static long EZC_LOG_SAMPLE = 0;
+
+
+
+/* Rate limiting state of a single `ezc_log` call, identified by its file and
+ * line. A slot is taken once `file` is set, which happens last. */
+typedef struct ezc_log_site
+{
+    char const *file;
+    long line;
+    ezc_log_t type;
+
+    /* Second that `count` is for */
+    long window;
+
+    /* Messages let through during `window` */
+    long count;
+
+    /* Messages over the limit so far, for sampling */
+    long over;
+
+    /* Messages dropped since the last summary */
+    long suppressed;
+}
+ezc_log_site;
+
+/* Open addressing table of call sites. Slots are only ever taken under
+ * `EZC_LOG_SITES_LOCK` and never given back. */
+static ezc_log_site EZC_LOG_SITE_TABLE[EZC_LOG_SITES];
+static pthread_mutex_t EZC_LOG_SITES_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+/* Second in which sites were last checked for unreported summaries */
+static long EZC_LOG_SITES_SWEPT = 0;
+
+
+
+static char const * const EZC_LOG_TAGS[] = { "INF", "WRN", "ERR", "FTL" };
+
+#define EZC_LOG_TAG(type) \
+    ((type) >= EZC_LOG_INFO && (type) <= EZC_LOG_FATAL ? \
+     EZC_LOG_TAGS[type] : "???")
+
+
+
+/* How a record holds on to its message. */
+typedef enum ezc_log_kind_t
+{
+    /* Formatted right away */
+    EZC_LOG_KIND_TEXT = 0,
+
+    /* `printf` format string plus raw arguments, see `EZC_LOG_MODE_BINARY` */
+    EZC_LOG_KIND_BINARY,
+
+    /* Plain message plus key/value fields, see `ezc_log_kv` */
+    EZC_LOG_KIND_FIELDS
+}
+ezc_log_kind_t;
 
 
 
+/* The text, raw arguments or fields of a record follow right after it,
+ * within the same allocation. */
 typedef struct ezc_log_data
 {
     ezc_log_t type;
+    ezc_log_kind_t kind;
+
+    /* Formatted text of text records, `NULL` otherwise */
     char *message;
+
+    /* Where it was logged from */
+    char const *file;
+    long line;
+
+    /* Format string of binary records, or plain message of records with
+     * fields. `args` is the number of bytes of arguments or fields. */
+    char const *format;
+    long args;
+
+    /* Bytes taken up by the record and its text or arguments together */
+    long size;
+
+    /* Position in the order in which records were logged by all threads */
+    long sequence;
+    time_t time;
+
+    /* Number of the previous record of the same level in its ring, see
+     * `ezc_log_ring` */
+    long previous;
+
+    /* Allocator the record came from, unless it came from the pool */
+    ezc_allocator const *allocator;
+    int pooled;
 }
 ezc_log_data;
 
 
 
-void ezc_log__(char const *file, long line,
-               ezc_log_t type, char const *message, ...)
+/* File that messages are appended to as they are logged. */
+typedef struct ezc_log_file
 {
-    va_list args;
-    va_start(args, message);
+    FILE *file;
+    char *path;
+    ezc_log_sync_t sync;
+
+    /* Rotation happens once the file would grow past `max_bytes` or is
+     * `max_seconds` old. 0 means never. */
+    long bytes, max_bytes;
+    long max_seconds;
+    time_t opened;
+}
+ezc_log_file;
+
+static ezc_log_file EZC_LOG_FILE;
+static pthread_mutex_t EZC_LOG_FILE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/* Memory-mapped file that messages are copied into. Writers reserve space by
+ * bumping `offset`, so it may end up past `size`. `writers` counts threads
+ * that might be copying into `map` right now. */
+typedef struct ezc_log_segment
+{
+    char *map;
+    long size, offset;
+    long writers;
+    int fd;
+}
+ezc_log_segment;
+
+/* Segments are only ever swapped under `EZC_LOG_SEGMENT_LOCK`. Their
+ * descriptors alternate between two static slots and are never freed, so a
+ * writer holding on to a stale one can still safely see that it is stale. */
+static ezc_log_segment EZC_LOG_SEGMENTS[2];
+static ezc_log_segment *EZC_LOG_SEGMENT = NULL;
+static char *EZC_LOG_SEGMENT_PATH = NULL;
+static pthread_mutex_t EZC_LOG_SEGMENT_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signalled when the last writer leaves a segment that is no longer current */
+static pthread_mutex_t EZC_LOG_SEGMENT_IDLE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t EZC_LOG_SEGMENT_IDLE = PTHREAD_COND_INITIALIZER;
+
+
+
+/* Kinds of arguments a `printf` conversion specification takes. */
+typedef enum ezc_log_arg_t
+{
+    EZC_LOG_ARG_NONE = 0,
+    EZC_LOG_ARG_INT,
+    EZC_LOG_ARG_LONG,
+    EZC_LOG_ARG_DOUBLE,
+    EZC_LOG_ARG_LONG_DOUBLE,
+    EZC_LOG_ARG_STRING,
+    EZC_LOG_ARG_POINTER
+}
+ezc_log_arg_t;
+
+
+
+/* Number of log levels that get their own index. Records of other types are
+ * indexed along with the nearest level. */
+#define EZC_LOG_LEVELS (EZC_LOG_FATAL + 1)
+
+#define EZC_LOG_LEVEL_OF(type) \
+    ((type) < EZC_LOG_INFO ? EZC_LOG_INFO : \
+     (type) > EZC_LOG_FATAL ? EZC_LOG_FATAL : (type))
 
-    int is_fatal = 0;
 
-    ezc_log_data *log;
-    EZC_NEW(log);
 
-    log->type = type;
-    EZC_NEWN(log->message, EZC_LOG_BUFFER_SIZE);
-    strcat(log->message, ">> ");
+/* Fixed-capacity ring of the most recent records, oldest first. Once either
+ * budget is exceeded the oldest records are overwritten. */
+typedef struct ezc_log_ring
+{
+    ezc_log_data **records;
+    long capacity, head, length;
+    long bytes, max_bytes;
+
+    /* Number of records ever pushed, and the number of the latest record of
+     * each level. Records are numbered from 1, and 0 means none. A record is
+     * still around if its number is past `total - length`. Each record links
+     * to the previous one of its level by number, so that the records of a
+     * level can be walked newest first without looking at any others. */
+    long total, latest[EZC_LOG_LEVELS];
+}
+ezc_log_ring;
+
+
+
+/* Newest record is at `n == 0`. */
+#define EZC_LOG_RING_AT(ring, n) \
+    ((ring)->records[((ring)->head + (ring)->length - 1 - (n)) % \
+                     (ring)->capacity])
+
+
+
+/* Each thread logs into its own ring. Only the owning thread ever adds to
+ * it, so `lock` is uncontended unless another thread is reading the log at
+ * the same time. Rings are published through a lock-free, push-only list and
+ * outlive their thread: a later thread adopts the ring of one that exited. */
+typedef struct ezc_log_thread
+{
+    pthread_mutex_t lock;
+    ezc_log_ring ring;
+
+    /* Copy of the message last handed out by `ezc_log_get` */
+    char *got;
+
+    int owned;
+    struct ezc_log_thread *next;
+}
+ezc_log_thread;
+
+static ezc_log_thread *EZC_LOG_THREADS = NULL;
+static long EZC_LOG_SEQUENCE = 0;
+static long EZC_LOG_RECORDS = EZC_LOG_DEFAULT_RECORDS;
+static long EZC_LOG_BYTES = 0;
+static ezc_allocator const *EZC_LOG_ALLOCATOR = NULL;
+static ezc_mem_pool *EZC_LOG_POOL = NULL;
+static pthread_once_t EZC_LOG_POOL_ONCE = PTHREAD_ONCE_INIT;
+
+static pthread_key_t EZC_LOG_KEY;
+static pthread_once_t EZC_LOG_ONCE = PTHREAD_ONCE_INIT;
+
+
+
+/* Bounded lock-free multi-producer queue of message copies waiting for the
+ * writer thread, after Dmitry Vyukov's bounded MPMC queue. Each cell's
+ * `sequence` tells whether it is ready to be written to or read from for a
+ * given position. `lock` only serves starting, stopping and sleeping. */
+typedef struct ezc_log_cell
+{
+    long sequence;
+    char *message;
+}
+ezc_log_cell;
+
+typedef struct ezc_log_queue
+{
+    ezc_log_cell *cells;
+    long capacity;
+    long enqueue_pos, dequeue_pos;
+
+    /* Messages accepted and messages done with, for `ezc_log_flush` */
+    long pushed, popped;
+
+    /* Threads inside `ezc_log_enqueue`, and those of them waiting for room */
+    long producers, blocked;
+
+    int running, sleeping;
+    ezc_log_full_t full;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, drained, room;
+}
+ezc_log_queue;
+
+static ezc_log_queue EZC_LOG_QUEUE;
+static pthread_mutex_t EZC_LOG_QUEUE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+static void ezc_log_pool_create()
+{
+    EZC_LOG_POOL = ezc_mem_pool_new(EZC_LOG_POOLED_SIZE);
+    EZC_MEM_KEEP(EZC_LOG_POOL);
+}
+
+
 
-    switch (type)
+/* Allocate a record with `extra` bytes of text or arguments behind it. */
+static ezc_log_data* ezc_log_data_new(long extra)
+{
+    ezc_allocator const *allocator = EZC_ATOMIC_LOAD(&EZC_LOG_ALLOCATOR);
+    ezc_log_data *log = NULL;
+
+    if (allocator == NULL && sizeof *log + extra <= EZC_LOG_POOLED_SIZE)
     {
-        case EZC_LOG_INFO:
-            strcat(log->message, "INF");
-            break;
-        case EZC_LOG_WARN:
-            strcat(log->message, "WRN");
-            break;
-        case EZC_LOG_ERROR:
-            strcat(log->message, "ERR");
-            break;
-        case EZC_LOG_FATAL:
-            strcat(log->message, "FTL");
-            is_fatal = 1;
-            break;
-        default:
-            strcat(log->message, "???");
-            break;
+        pthread_once(&EZC_LOG_POOL_ONCE, ezc_log_pool_create);
+
+        if (EZC_LOG_POOL != NULL &&
+                (log = ezc_mem_pool_alloc(EZC_LOG_POOL)) != NULL)
+        {
+            log->pooled = 1;
+            return log;
+        }
     }
 
-    char *buf;
-    EZC_NEWN(buf, EZC_LOG_BUFFER_SIZE);
-    snprintf(buf, EZC_LOG_BUFFER_SIZE, " @ %s:%u <<\n", file, line);
-    strcat(log->message, buf);
-    EZC_FREE(buf);
+    if (allocator == NULL) allocator = EZC_MEM_GLOBAL;
+    log = EZC_MEM_ALLOC(allocator, sizeof *log + extra);
 
-    EZC_NEWN(buf, EZC_LOG_BUFFER_SIZE);
-    vsnprintf(buf, EZC_LOG_BUFFER_SIZE, message, args);
-    strcat(log->message, buf);
-    EZC_FREE(buf);
+    if (log != NULL)
+    {
+        log->allocator = allocator;
+        log->pooled = 0;
+        EZC_MEM_KEEP(log);
+    }
+
+    return log;
+}
+
+
+
+static void ezc_log_data_delete(ezc_log_data *log)
+{
+    if (log == NULL) return;
+
+    if (log->pooled) ezc_mem_pool_free(EZC_LOG_POOL, log);
+    else EZC_MEM_FREE(log->allocator, log);
+}
+
+
+
+static void ezc_log_ring_pop(ezc_log_ring *ring)
+{
+    ezc_log_data *oldest = ring->records[ring->head];
 
-    strcat(log->message, "\n\n");
+    ring->bytes -= oldest->size;
+    ring->head = (ring->head + 1) % ring->capacity;
+    ring->length--;
 
-    if (EZC_LOG_LIST == NULL)
+    ezc_log_data_delete(oldest);
+}
+
+
+
+/* Returns 0 if the memory could not be allocated. */
+static int ezc_log_ring_resize(ezc_log_ring *ring, long records, long bytes)
+{
+    ezc_log_data **resized;
+    long i;
+
+    EZC_NEWN(resized, records);
+    if (resized == NULL) return 0;
+    EZC_MEM_KEEP(resized);
+
+    /* Keep as many of the most recent records as the new budgets allow */
+    ring->max_bytes = bytes;
+
+    while (ring->length > records ||
+            (bytes > 0 && ring->length > 0 && ring->bytes > bytes))
     {
-        EZC_LOG_LIST = ezc_list_new(log);
+        ezc_log_ring_pop(ring);
     }
-    else
+
+    for (i = 0; i < ring->length; i++)
     {
-        ezc_list_push_front(EZC_LOG_LIST, log);
+        resized[i] = ring->records[(ring->head + i) % ring->capacity];
     }
 
-    if (EZC_LOG_ECHO_DEST != NULL)
+    EZC_FREE(ring->records);
+    ring->records = resized;
+    ring->capacity = records;
+    ring->head = 0;
+
+    return 1;
+}
+
+
+
+/* Record with the given number, if it is still around. */
+static ezc_log_data* ezc_log_ring_numbered(ezc_log_ring const *ring,
+                                          long number)
+{
+    long const OLDEST = ring->total - ring->length;
+
+    return number <= OLDEST ? NULL :
+        ring->records[(ring->head + number - 1 - OLDEST) % ring->capacity];
+}
+
+
+
+/* Latest record indexed under the given level, if it is still around. */
+static ezc_log_data* ezc_log_ring_latest(ezc_log_ring const *ring, int level)
+{
+    return ezc_log_ring_numbered(ring, ring->latest[level]);
+}
+
+
+
+/* Takes ownership of the record. */
+static void ezc_log_ring_push(ezc_log_ring *ring, ezc_log_data *log)
+{
+    if (ring->capacity == 0 && !ezc_log_ring_resize(ring,
+                EZC_ATOMIC_LOAD(&EZC_LOG_RECORDS),
+                EZC_ATOMIC_LOAD(&EZC_LOG_BYTES)))
     {
-        fprintf(EZC_LOG_ECHO_DEST, log->message);
+        ezc_log_data_delete(log);
+        return;
     }
 
-    va_end(args);
-
-    if (is_fatal)
+    while (ring->length > 0 && (ring->length == ring->capacity ||
+                (ring->max_bytes > 0 &&
+                 ring->bytes + log->size > ring->max_bytes)))
     {
-        ezc_log_fwrite();
-        abort();
+        ezc_log_ring_pop(ring);
     }
+
+    ring->records[(ring->head + ring->length) % ring->capacity] = log;
+    ring->length++;
+    ring->bytes += log->size;
+    log->previous = ring->latest[EZC_LOG_LEVEL_OF(log->type)];
+    ring->latest[EZC_LOG_LEVEL_OF(log->type)] = ++ring->total;
 }
 
 
 
-void ezc_log_echo(FILE *dest)
+static void ezc_log_thread_release(void *self)
 {
-    EZC_LOG_ECHO_DEST = dest;
+    EZC_ATOMIC_STORE(&((ezc_log_thread *) self)->owned, 0);
 }
 
 
 
-char const* ezc_log_get(ezc_log_t type)
+static void ezc_log_key_create()
+{
+    pthread_key_create(&EZC_LOG_KEY, ezc_log_thread_release);
+}
+
+
+
+/* The calling thread's log, which is created on first use. */
+static ezc_log_thread* ezc_log_thread_get()
 {
-    ezc_list *iter = EZC_LOG_LIST;
+    ezc_log_thread *self, *iter;
+
+    pthread_once(&EZC_LOG_ONCE, ezc_log_key_create);
+    self = pthread_getspecific(EZC_LOG_KEY);
 
-    while (iter != NULL)
+    if (self == NULL)
     {
-        if (((ezc_log_data *) iter->data)->type >= type)
+        /* Adopt the log of a thread that has exited, if there is one */
+        for (iter = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS); iter != NULL;
+                iter = iter->next)
         {
-            break;
+            if (!EZC_ATOMIC_LOAD(&iter->owned) &&
+                    EZC_ATOMIC_CAS(&iter->owned, 0, 1))
+            {
+                self = iter;
+                break;
+            }
+        }
+
+        if (self == NULL)
+        {
+            EZC_NEW0(self);
+            if (self == NULL) return NULL;
+            EZC_MEM_KEEP(self);
+
+            pthread_mutex_init(&self->lock, NULL);
+            self->owned = 1;
+
+            do
+            {
+                self->next = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS);
+            }
+            while (!EZC_ATOMIC_CAS(&EZC_LOG_THREADS, self->next, self));
         }
 
-        iter = iter->next;
+        pthread_setspecific(EZC_LOG_KEY, self);
     }
 
-    return iter == NULL ? NULL : ((ezc_log_data *) iter->data)->message;
+    return self;
 }
 
 
 
-void ezc_log_fwrite()
+/* Create a new file named `stem` followed by `ext`, or else `stem-N`
+ * followed by `ext` for the first N that is not taken. Its name is written
+ * to `name`. Returns its file descriptor, or -1. */
+static int ezc_log_create(char *name, long size, char const *stem,
+                          char const *ext)
 {
-    time_t rawtime;
-    struct tm *infotime;
+    long n;
+
+    for (n = 0; n < 1000; n++)
+    {
+        int fd;
+
+        if (n == 0) snprintf(name, size, "%s%s", stem, ext);
+        else snprintf(name, size, "%s-%li%s", stem, n, ext);
+
+        fd = open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+        if (fd >= 0 || errno != EEXIST) return fd;
+    }
+
+    return -1;
+}
+
+
+
+static FILE* ezc_log_fcreate(char *name, long size, char const *stem,
+                             char const *ext)
+{
+    int const fd = ezc_log_create(name, size, stem, ext);
+    FILE *file = NULL;
+
+    if (fd >= 0 && (file = fdopen(fd, "w")) == NULL) close(fd);
+
+    return file;
+}
 
-    time(&rawtime);
-    infotime = localtime(&rawtime);
 
-    char buf[26];
-    strftime(buf, 26, "%Y-%m-%d-%H-%M-%S.error", infotime);
 
-    FILE *file = fopen(buf, "w");
-    ezc_list *iter = EZC_LOG_LIST;
+/* (Re)open the log file for appending. */
+static void ezc_log_file_reopen(ezc_log_file *sink)
+{
+    FILE * const file = fopen(sink->path, "a");
 
     if (file != NULL)
     {
-        while (iter != NULL)
+        if (sink->sync == EZC_LOG_SYNC_BUFFERED)
         {
-            char const * const message =
-                ((ezc_log_data *) iter->data)->message;
-            fwrite(message, sizeof(char), strlen(message), file);
-            iter = iter->next;
+            setvbuf(file, NULL, _IOFBF, EZC_LOG_FILE_BUFFER);
         }
+
+        fseek(file, 0, SEEK_END);
+        sink->bytes = ftell(file);
+        sink->opened = time(NULL);
     }
-    else
+
+    EZC_ATOMIC_STORE(&sink->file, file);
+}
+
+
+
+/* Move the log file aside under a timestamped name and start a new one. If
+ * the new one cannot be opened, file logging stops. Logging about it here
+ * could deadlock, hence the silence. */
+static void ezc_log_file_rotate(ezc_log_file *sink)
+{
+    long const SIZE = strlen(sink->path) + 64;
+    char *stem, *name;
+    time_t now = time(NULL);
+    FILE *placeholder;
+
+    fclose(sink->file);
+    EZC_ATOMIC_STORE(&sink->file, (FILE *) NULL);
+
+    EZC_NEWN(stem, SIZE);
+    EZC_NEWN(name, SIZE);
+
+    if (stem != NULL && name != NULL)
     {
-        ezc_log(EZC_LOG_ERROR, "Unable to write log to file. "
-                "Error while opening/creating file.");
+        char stamp[32];
+
+        strftime(stamp, sizeof stamp, "%Y-%m-%d-%H-%M-%S", localtime(&now));
+        snprintf(stem, SIZE, "%s.%s", sink->path, stamp);
+
+        /* Claim a free name first so that renaming never clobbers a file */
+        if ((placeholder = ezc_log_fcreate(name, SIZE, stem, "")) != NULL)
+        {
+            fclose(placeholder);
+            if (rename(sink->path, name) != 0) remove(name);
+        }
     }
 
-    fclose(file);
+    EZC_FREE(stem, name);
+    ezc_log_file_reopen(sink);
 }
 
 
 
-void ezc_log_clear()
+static void ezc_log_file_write(char const *message)
+{
+    ezc_log_file * const sink = &EZC_LOG_FILE;
+
+    if (EZC_ATOMIC_LOAD(&sink->file) == NULL) return;
+
+    pthread_mutex_lock(&EZC_LOG_FILE_LOCK);
+
+    if (sink->file != NULL)
+    {
+        long const LENGTH = strlen(message);
+
+        if ((sink->max_bytes > 0 && sink->bytes > 0 &&
+                    sink->bytes + LENGTH > sink->max_bytes) ||
+                (sink->max_seconds > 0 &&
+                 time(NULL) - sink->opened >= sink->max_seconds))
+        {
+            ezc_log_file_rotate(sink);
+        }
+
+        if (sink->file != NULL)
+        {
+            fwrite(message, sizeof(char), LENGTH, sink->file);
+            sink->bytes += LENGTH;
+
+            if (sink->sync != EZC_LOG_SYNC_BUFFERED) fflush(sink->file);
+            if (sink->sync == EZC_LOG_SYNC_FSYNC) fsync(fileno(sink->file));
+        }
+    }
+
+    pthread_mutex_unlock(&EZC_LOG_FILE_LOCK);
+}
+
+
+
+static void ezc_log_deadline(struct timespec *deadline, long ms)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    deadline->tv_sec = now.tv_sec + ms / 1000;
+    deadline->tv_nsec = now.tv_usec * 1000L + (ms % 1000) * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+
+
+/* Map a new segment into the given slot. Returns 0 on failure. */
+static int ezc_log_segment_map(ezc_log_segment *segment, long size)
 {
-    ezc_list_delete(EZC_LOG_LIST);
+    long const NAME_SIZE = strlen(EZC_LOG_SEGMENT_PATH) + 32;
+    char *name;
+    int fd = -1;
+
+    EZC_NEWN(name, NAME_SIZE);
+
+    if (name != NULL)
+    {
+        fd = ezc_log_create(name, NAME_SIZE, EZC_LOG_SEGMENT_PATH, "");
+        EZC_FREE(name);
+    }
+
+    if (fd < 0) return 0;
+
+    /* Preallocate the whole segment. Unwritten bytes read as zero. */
+    segment->map = MAP_FAILED;
+
+    if (ftruncate(fd, size) == 0)
+    {
+        segment->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+    }
+
+    if (segment->map == MAP_FAILED)
+    {
+        segment->map = NULL;
+        close(fd);
+        return 0;
+    }
+
+    segment->fd = fd;
+    segment->size = size;
+    segment->offset = 0;
+
+    return 1;
+}
+
+
+
+/* Wait for the segment's last writers, then unmap it and cut off the unused
+ * tail of the file. The segment must not be current anymore. */
+static void ezc_log_segment_unmap(ezc_log_segment *segment)
+{
+    struct timespec deadline;
+    long used;
+
+    /* The last writer may leave without seeing that the segment is retired,
+     * in which case nobody signals. The timeout bounds the delay. */
+    pthread_mutex_lock(&EZC_LOG_SEGMENT_IDLE_LOCK);
+
+    while (EZC_ATOMIC_LOAD(&segment->writers) > 0)
+    {
+        ezc_log_deadline(&deadline, 1);
+        pthread_cond_timedwait(&EZC_LOG_SEGMENT_IDLE,
+                &EZC_LOG_SEGMENT_IDLE_LOCK, &deadline);
+    }
+
+    pthread_mutex_unlock(&EZC_LOG_SEGMENT_IDLE_LOCK);
+
+    /* Only read now, as writers that got in before the segment was retired
+     * may still have reserved space. Reservations that did not fit leave
+     * zeroes behind, but only at the very end. */
+    used = EZC_ATOMIC_LOAD(&segment->offset);
+    if (used > segment->size) used = segment->size;
+    while (used > 0 && segment->map[used - 1] == '\0') used--;
+
+    munmap(segment->map, segment->size);
+    ftruncate(segment->fd, used);
+    close(segment->fd);
+
+    segment->map = NULL;
+}
+
+
+
+/* Undo a writer's announcement, waking whoever waits to unmap the segment
+ * if it was the last one. */
+static void ezc_log_segment_leave(ezc_log_segment *segment)
+{
+    if (EZC_ATOMIC_ADD(&segment->writers, -1) == 1 &&
+            segment != EZC_ATOMIC_LOAD(&EZC_LOG_SEGMENT))
+    {
+        pthread_mutex_lock(&EZC_LOG_SEGMENT_IDLE_LOCK);
+        pthread_cond_broadcast(&EZC_LOG_SEGMENT_IDLE);
+        pthread_mutex_unlock(&EZC_LOG_SEGMENT_IDLE_LOCK);
+    }
+}
+
+
+
+static void ezc_log_segment_write(char const *message)
+{
+    long const LENGTH = strlen(message);
+
+    while (1)
+    {
+        ezc_log_segment * const segment = EZC_ATOMIC_LOAD(&EZC_LOG_SEGMENT);
+        long at;
+
+        if (segment == NULL) return;
+
+        /* Announce ourselves, then make sure the segment was not retired in
+         * the meantime. Only then is it safe to look at, since a retired
+         * segment may be mapped anew at any time. */
+        EZC_ATOMIC_ADD(&segment->writers, 1);
+
+        if (segment != EZC_ATOMIC_LOAD(&EZC_LOG_SEGMENT))
+        {
+            ezc_log_segment_leave(segment);
+            continue;
+        }
+
+        if (LENGTH > segment->size)
+        {
+            ezc_log_segment_leave(segment);
+            return;
+        }
+
+        at = EZC_ATOMIC_ADD(&segment->offset, LENGTH);
+
+        if (at + LENGTH <= segment->size)
+        {
+            memcpy(segment->map + at, message, LENGTH);
+            ezc_log_segment_leave(segment);
+            return;
+        }
+
+        ezc_log_segment_leave(segment);
+
+        /* Full, so roll over to a new segment unless another thread already
+         * did. The slot may have been mapped anew since, so it must still be
+         * full, too. If mapping fails, segment logging stops. Logging about
+         * it here could deadlock, hence the silence. */
+        pthread_mutex_lock(&EZC_LOG_SEGMENT_LOCK);
+
+        if (segment == EZC_LOG_SEGMENT &&
+                EZC_ATOMIC_LOAD(&segment->offset) > segment->size)
+        {
+            ezc_log_segment * const next = (segment == EZC_LOG_SEGMENTS ?
+                    &EZC_LOG_SEGMENTS[1] : &EZC_LOG_SEGMENTS[0]);
+
+            EZC_ATOMIC_STORE(&EZC_LOG_SEGMENT,
+                    (ezc_log_segment_map(next, segment->size) ? next : NULL));
+            ezc_log_segment_unmap(segment);
+        }
+
+        pthread_mutex_unlock(&EZC_LOG_SEGMENT_LOCK);
+    }
+}
+
+
+
+static void ezc_log_emit(char const *message)
+{
+    FILE * const dest = EZC_ATOMIC_LOAD(&EZC_LOG_ECHO_DEST);
+
+    if (dest != NULL)
+    {
+        fputs(message, dest);
+    }
+
+    ezc_log_file_write(message);
+}
+
+
+
+static int ezc_log_queue_push(ezc_log_queue *queue, char *message)
+{
+    long pos = EZC_ATOMIC_LOAD(&queue->enqueue_pos);
+    ezc_log_cell *cell;
+
+    while (1)
+    {
+        long diff;
+
+        cell = &queue->cells[pos % queue->capacity];
+        diff = EZC_ATOMIC_LOAD(&cell->sequence) - pos;
+
+        if (diff == 0)
+        {
+            if (EZC_ATOMIC_CAS(&queue->enqueue_pos, pos, pos + 1)) break;
+            pos = EZC_ATOMIC_LOAD(&queue->enqueue_pos);
+        }
+        else if (diff < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            pos = EZC_ATOMIC_LOAD(&queue->enqueue_pos);
+        }
+    }
+
+    cell->message = message;
+    EZC_ATOMIC_STORE(&cell->sequence, pos + 1);
+    return 1;
+}
+
+
+
+static char* ezc_log_queue_pop(ezc_log_queue *queue)
+{
+    long pos = EZC_ATOMIC_LOAD(&queue->dequeue_pos);
+    ezc_log_cell *cell;
+    char *message;
+
+    while (1)
+    {
+        long diff;
+
+        cell = &queue->cells[pos % queue->capacity];
+        diff = EZC_ATOMIC_LOAD(&cell->sequence) - (pos + 1);
+
+        if (diff == 0)
+        {
+            if (EZC_ATOMIC_CAS(&queue->dequeue_pos, pos, pos + 1)) break;
+            pos = EZC_ATOMIC_LOAD(&queue->dequeue_pos);
+        }
+        else if (diff < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            pos = EZC_ATOMIC_LOAD(&queue->dequeue_pos);
+        }
+    }
+
+    message = cell->message;
+    EZC_ATOMIC_STORE(&cell->sequence, pos + queue->capacity);
+    return message;
+}
+
+
+
+static void* ezc_log_writer(void *arg)
+{
+    ezc_log_queue * const queue = arg;
+
+    while (1)
+    {
+        char *message = ezc_log_queue_pop(queue);
+        struct timespec deadline;
+
+        if (message != NULL)
+        {
+            if (EZC_ATOMIC_LOAD(&queue->blocked) > 0)
+            {
+                pthread_mutex_lock(&queue->lock);
+                pthread_cond_broadcast(&queue->room);
+                pthread_mutex_unlock(&queue->lock);
+            }
+
+            ezc_log_emit(message);
+            EZC_FREE(message);
+            EZC_ATOMIC_ADD(&queue->popped, 1);
+            continue;
+        }
+
+        /* Queue is empty */
+        {
+            FILE * const dest = EZC_ATOMIC_LOAD(&EZC_LOG_ECHO_DEST);
+            if (dest != NULL) fflush(dest);
+        }
+
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_broadcast(&queue->drained);
+
+        if (!EZC_ATOMIC_LOAD(&queue->running))
+        {
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+
+        /* Producers only signal when they see us sleeping and never take
+         * the lock, so a wakeup may be missed. The timeout bounds the delay
+         * in that case. */
+        EZC_ATOMIC_STORE(&queue->sleeping, 1);
+        ezc_log_deadline(&deadline, EZC_LOG_POLL_MS);
+        pthread_cond_timedwait(&queue->wake, &queue->lock, &deadline);
+        EZC_ATOMIC_STORE(&queue->sleeping, 0);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    return NULL;
+}
+
+
+
+/* Wait until the writer pops a message or the queue stops. Returns 0 if it
+ * stopped. */
+static int ezc_log_queue_wait(ezc_log_queue *queue, char *copy)
+{
+    int pushed = 0;
+    struct timespec deadline;
+
+    EZC_ATOMIC_ADD(&queue->blocked, 1);
+    pthread_mutex_lock(&queue->lock);
+
+    /* The writer may pop right before seeing us blocked and thus not
+     * signal. The timeout bounds the delay in that case. */
+    while (EZC_ATOMIC_LOAD(&queue->running) &&
+            !(pushed = ezc_log_queue_push(queue, copy)))
+    {
+        ezc_log_deadline(&deadline, EZC_LOG_POLL_MS);
+        pthread_cond_timedwait(&queue->room, &queue->lock, &deadline);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    EZC_ATOMIC_ADD(&queue->blocked, -1);
+
+    return pushed;
+}
+
+
+
+/* Hand a copy of the message to the writer thread. Returns 0 if the queue is
+ * not running, in which case the caller has to echo the message itself.
+ * `producers` lets `ezc_log_async_stop` wait for callers that saw the queue
+ * running, so that none of their messages get stranded in it. */
+static int ezc_log_enqueue(char const *message, long length)
+{
+    ezc_log_queue * const queue = &EZC_LOG_QUEUE;
+    char *copy = NULL;
+    int queued = 1;
+
+    EZC_ATOMIC_ADD(&queue->producers, 1);
+
+    if (!EZC_ATOMIC_LOAD(&queue->running))
+    {
+        queued = 0;
+    }
+    else
+    {
+        EZC_NEWN(copy, length + 1);
+        if (copy != NULL) memcpy(copy, message, length + 1);
+    }
+
+    while (copy != NULL && !ezc_log_queue_push(queue, copy))
+    {
+        ezc_log_full_t const full = EZC_ATOMIC_LOAD(&queue->full);
+
+        if (full == EZC_LOG_FULL_DROP)
+        {
+            EZC_FREE(copy);
+        }
+        else if (full == EZC_LOG_FULL_DROP_OLDEST)
+        {
+            char *oldest = ezc_log_queue_pop(queue);
+
+            if (oldest != NULL)
+            {
+                EZC_FREE(oldest);
+                EZC_ATOMIC_ADD(&queue->popped, 1);
+            }
+        }
+        else if (!ezc_log_queue_wait(queue, copy))
+        {
+            EZC_FREE(copy);
+            queued = 0;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (copy != NULL)
+    {
+        EZC_ATOMIC_ADD(&queue->pushed, 1);
+
+        if (EZC_ATOMIC_LOAD(&queue->sleeping))
+        {
+            pthread_cond_signal(&queue->wake);
+        }
+    }
+
+    /* The last one out of a stopped queue lets `ezc_log_async_stop` know */
+    if (EZC_ATOMIC_ADD(&queue->producers, -1) == 1 &&
+            !EZC_ATOMIC_LOAD(&queue->running))
+    {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_broadcast(&queue->drained);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    return queued;
+}
+
+
+
+/* Write the header every message starts with. Returns its length. */
+static long ezc_log_header(char *buf, ezc_log_t type, char const *file,
+                           long line)
+{
+    long const length = snprintf(buf, EZC_LOG_BUFFER_SIZE,
+            ">> %s @ %s:%ld <<\n", EZC_LOG_TAG(type), file, line);
+
+    return length < 0 ? 0 : length;
+}
+
+
+
+/* End the message with the usual blank line, truncating it if needed.
+ * Returns its final length. */
+static long ezc_log_finish(char *buf, long length)
+{
+    if (length < 0) length = 0;
+    if (length > EZC_LOG_BUFFER_SIZE - 3) length = EZC_LOG_BUFFER_SIZE - 3;
+    memcpy(buf + length, "\n\n", 3);
+
+    return length + 2;
+}
+
+
+
+/* Parse the conversion specification right after a '%'. Sets `*stars` to how
+ * many `*` widths and precisions it takes and `*arg` to the kind of value it
+ * converts. Returns the end of the specification. Integers wider than `int`
+ * are taken to be as wide as `long`, which holds for `size_t`, `ptrdiff_t`
+ * and `intmax_t` on the platforms we target. */
+static char const* ezc_log_spec(char const *spec, int *stars,
+                                ezc_log_arg_t *arg)
+{
+    int wide = 0, extended = 0;
+
+    *stars = 0;
+    *arg = EZC_LOG_ARG_NONE;
+
+    while (*spec != '\0' && strchr("-+ #0'", *spec) != NULL) spec++;
+
+    if (*spec == '*') (*stars)++, spec++;
+    while (isdigit((unsigned char) *spec)) spec++;
+
+    if (*spec == '.')
+    {
+        spec++;
+        if (*spec == '*') (*stars)++, spec++;
+        while (isdigit((unsigned char) *spec)) spec++;
+    }
+
+    while (*spec != '\0' && strchr("hlLqjzt", *spec) != NULL)
+    {
+        if (*spec == 'L') extended = 1;
+        else if (*spec != 'h') wide = 1;
+        spec++;
+    }
+
+    switch (*spec)
+    {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            *arg = (wide ? EZC_LOG_ARG_LONG : EZC_LOG_ARG_INT);
+            break;
+
+        case 'c':
+            *arg = EZC_LOG_ARG_INT;
+            break;
+
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G':
+        case 'a': case 'A':
+            *arg = (extended ? EZC_LOG_ARG_LONG_DOUBLE : EZC_LOG_ARG_DOUBLE);
+            break;
+
+        case 's':
+            *arg = EZC_LOG_ARG_STRING;
+            break;
+
+        case 'p': case 'n':
+            *arg = EZC_LOG_ARG_POINTER;
+            break;
+
+        case '\0':
+            return spec;
+    }
+
+    return spec + 1;
+}
+
+
+
+#define EZC_LOG_PACK(type) \
+    do \
+    { \
+        type const value = va_arg(args, type); \
+        if (used + (long) sizeof value > size) return -1; \
+        memcpy(buf + used, &value, sizeof value); \
+        used += sizeof value; \
+    } \
+    while (0)
+
+/* Copy the arguments `format` converts into `buf` as they are, except for
+ * strings, which are copied whole. Returns the number of bytes used, or -1
+ * if they do not fit. */
+static long ezc_log_pack(char *buf, long size, char const *format,
+                         va_list args)
+{
+    long used = 0;
+
+    while ((format = strchr(format, '%')) != NULL)
+    {
+        ezc_log_arg_t arg;
+        int stars;
+
+        format = ezc_log_spec(format + 1, &stars, &arg);
+
+        while (stars-- > 0) EZC_LOG_PACK(int);
+
+        switch (arg)
+        {
+            case EZC_LOG_ARG_INT: EZC_LOG_PACK(int); break;
+            case EZC_LOG_ARG_LONG: EZC_LOG_PACK(long); break;
+            case EZC_LOG_ARG_DOUBLE: EZC_LOG_PACK(double); break;
+            case EZC_LOG_ARG_LONG_DOUBLE: EZC_LOG_PACK(long double); break;
+            case EZC_LOG_ARG_POINTER: EZC_LOG_PACK(void *); break;
+
+            case EZC_LOG_ARG_STRING:
+            {
+                char const *str = va_arg(args, char const *);
+                long length;
+
+                if (str == NULL) str = "(null)";
+                length = strlen(str) + 1;
+
+                if (used + length > size) return -1;
+                memcpy(buf + used, str, length);
+                used += length;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    return used;
+}
+
+#undef EZC_LOG_PACK
+
+
+
+/* Append `printf` style to the text in `buf`, which holds `size` bytes.
+ * Returns the new length, which stays below `size`. */
+static long ezc_log_appendf(char *buf, long length, long size,
+                            char const *format, ...)
+{
+    va_list args;
+    long written;
+
+    if (length >= size - 1) return length;
+
+    va_start(args, format);
+    written = vsnprintf(buf + length, size - length, format, args);
+    va_end(args);
+
+    if (written < 0) return length;
+    return (written < size - length ? length + written : size - 1);
+}
+
+
+
+/* A key/value field as packed by `ezc_log_kv__`: a tag byte, the key and its
+ * NUL, then the value as is, or the string and its NUL. */
+typedef struct ezc_log_field
+{
+    ezc_log_field_t type;
+    char const *key;
+
+    long i;
+    double d;
+    char const *s;
+    void *p;
+}
+ezc_log_field;
+
+
+
+/* Unpack the field at `raw`. Returns where the next one starts, or `NULL` if
+ * there are no more. */
+static char const* ezc_log_field_next(char const *raw, char const *end,
+                                      ezc_log_field *field)
+{
+    if (raw >= end) return NULL;
+
+    field->type = (unsigned char) *raw++;
+    field->key = raw;
+
+    if ((raw = memchr(raw, '\0', end - raw)) == NULL) return NULL;
+    raw++;
+
+    switch (field->type)
+    {
+        case EZC_LOG_FIELD_INT:
+            if (end - raw < (long) sizeof field->i) return NULL;
+            memcpy(&field->i, raw, sizeof field->i);
+            return raw + sizeof field->i;
+
+        case EZC_LOG_FIELD_DOUBLE:
+            if (end - raw < (long) sizeof field->d) return NULL;
+            memcpy(&field->d, raw, sizeof field->d);
+            return raw + sizeof field->d;
+
+        case EZC_LOG_FIELD_POINTER:
+            if (end - raw < (long) sizeof field->p) return NULL;
+            memcpy(&field->p, raw, sizeof field->p);
+            return raw + sizeof field->p;
+
+        case EZC_LOG_FIELD_STRING:
+            field->s = raw;
+            raw = memchr(raw, '\0', end - raw);
+            return raw != NULL ? raw + 1 : NULL;
+
+        default:
+            return NULL;
+    }
+}
+
+
+
+#define EZC_LOG_UNPACK(type, var) \
+    do \
+    { \
+        if (raw + sizeof(type) > end) goto truncated; \
+        memcpy(&(var), raw, sizeof(type)); \
+        raw += sizeof(type); \
+    } \
+    while (0)
+
+#define EZC_LOG_PRINT(value) \
+    (stars == 0 ? snprintf(out, room, spec, (value)) : \
+     stars == 1 ? snprintf(out, room, spec, star[0], (value)) : \
+     snprintf(out, room, spec, star[0], star[1], (value)))
+
+/* Format a binary record's message one conversion specification at a time,
+ * appending it to the text in `buf`. Returns the new length. */
+static long ezc_log_printf(ezc_log_data const *log, char *buf, long length)
+{
+    char const *raw = (char const *) (log + 1), *end = raw + log->args;
+    char const *format = log->format;
+
+    while (*format != '\0' && length < EZC_LOG_BUFFER_SIZE - 1)
+    {
+        char spec[64], *out = buf + length;
+        char const *next;
+        long const room = EZC_LOG_BUFFER_SIZE - length;
+        long written = 0;
+        int stars, star[2], i;
+        ezc_log_arg_t arg;
+
+        if (*format != '%')
+        {
+            buf[length++] = *format++;
+            continue;
+        }
+
+        next = ezc_log_spec(format + 1, &stars, &arg);
+
+        for (i = 0; i < stars; i++) EZC_LOG_UNPACK(int, star[i]);
+
+        /* Specifications this long are bogus, so only keep in sync */
+        if (next - format >= (long) sizeof spec)
+        {
+            spec[0] = '\0';
+        }
+        else
+        {
+            memcpy(spec, format, next - format);
+            spec[next - format] = '\0';
+        }
+
+        switch (arg)
+        {
+            case EZC_LOG_ARG_INT:
+            {
+                int value;
+                EZC_LOG_UNPACK(int, value);
+                if (*spec != '\0') written = EZC_LOG_PRINT(value);
+                break;
+            }
+
+            case EZC_LOG_ARG_LONG:
+            {
+                long value;
+                EZC_LOG_UNPACK(long, value);
+                if (*spec != '\0') written = EZC_LOG_PRINT(value);
+                break;
+            }
+
+            case EZC_LOG_ARG_DOUBLE:
+            {
+                double value;
+                EZC_LOG_UNPACK(double, value);
+                if (*spec != '\0') written = EZC_LOG_PRINT(value);
+                break;
+            }
+
+            case EZC_LOG_ARG_LONG_DOUBLE:
+            {
+                long double value;
+                EZC_LOG_UNPACK(long double, value);
+                if (*spec != '\0') written = EZC_LOG_PRINT(value);
+                break;
+            }
+
+            case EZC_LOG_ARG_POINTER:
+            {
+                void *value;
+                EZC_LOG_UNPACK(void *, value);
+
+                /* `%n` would write through a pointer that is long gone */
+                if (*spec != '\0' && next[-1] != 'n')
+                {
+                    written = EZC_LOG_PRINT(value);
+                }
+
+                break;
+            }
+
+            case EZC_LOG_ARG_STRING:
+            {
+                char const *value = raw;
+
+                while (raw < end && *raw != '\0') raw++;
+                if (raw == end) goto truncated;
+                raw++;
+
+                if (*spec != '\0') written = EZC_LOG_PRINT(value);
+                break;
+            }
+
+            default:
+                /* `%%` and the like */
+                if (*spec != '\0') written = snprintf(out, room, spec);
+                break;
+        }
+
+        if (written > 0) length += (written < room ? written : room - 1);
+        format = next;
+    }
+
+truncated:
+    buf[length] = '\0';
+    return length;
+}
+
+#undef EZC_LOG_UNPACK
+#undef EZC_LOG_PRINT
+
+
+
+/* Append the message of a record, without its header and trailing blank
+ * line, to the text in `buf`. Fields are written as `key=value`. Returns the
+ * new length. */
+static long ezc_log_body(ezc_log_data const *log, char *buf, long length)
+{
+    char const *raw = (char const *) (log + 1), *end = raw + log->args;
+    ezc_log_field field;
+
+    switch (log->kind)
+    {
+        case EZC_LOG_KIND_BINARY:
+            return ezc_log_printf(log, buf, length);
+
+        case EZC_LOG_KIND_FIELDS:
+            length = ezc_log_appendf(buf, length, EZC_LOG_BUFFER_SIZE, "%s",
+                    log->format);
+
+            while ((raw = ezc_log_field_next(raw, end, &field)) != NULL)
+            {
+                length = ezc_log_appendf(buf, length, EZC_LOG_BUFFER_SIZE,
+                        " %s=", field.key);
+
+                switch (field.type)
+                {
+                    case EZC_LOG_FIELD_INT:
+                        length = ezc_log_appendf(buf, length,
+                                EZC_LOG_BUFFER_SIZE, "%ld", field.i);
+                        break;
+
+                    case EZC_LOG_FIELD_DOUBLE:
+                        length = ezc_log_appendf(buf, length,
+                                EZC_LOG_BUFFER_SIZE, "%g", field.d);
+                        break;
+
+                    case EZC_LOG_FIELD_STRING:
+                        length = ezc_log_appendf(buf, length,
+                                EZC_LOG_BUFFER_SIZE, "\"%s\"", field.s);
+                        break;
+
+                    default:
+                        length = ezc_log_appendf(buf, length,
+                                EZC_LOG_BUFFER_SIZE, "%p", field.p);
+                        break;
+                }
+            }
+
+            return length;
+
+        default:
+        {
+            /* Strip the header line and the trailing blank line */
+            char const *body = strchr(log->message, '\n');
+            long size;
+
+            body = (body != NULL ? body + 1 : log->message);
+            size = strlen(body) - 2;
+            if (size < 0) size = 0;
+
+            return ezc_log_appendf(buf, length, EZC_LOG_BUFFER_SIZE, "%.*s",
+                    (int) size, body);
+        }
+    }
+}
+
+
+
+/* Write the text of a record into `buf`, which holds `EZC_LOG_BUFFER_SIZE`
+ * bytes, exactly as `ezc_log__` would have formatted it. Returns the length
+ * of the text. */
+static long ezc_log_format(ezc_log_data const *log, char *buf)
+{
+    long length;
+
+    if (log->kind == EZC_LOG_KIND_TEXT)
+    {
+        length = strlen(log->message);
+        memcpy(buf, log->message, length + 1);
+        return length;
+    }
+
+    length = ezc_log_header(buf, log->type, log->file, log->line);
+    length = ezc_log_body(log, buf, length);
+
+    return ezc_log_finish(buf, length);
+}
+
+
+
+/* Append `str` to the JSON in `buf`, quoted and escaped. Strings that do not
+ * fit are cut short, but the result is still valid JSON. */
+static long ezc_log_json_string(char *buf, long length, long size,
+                                char const *str)
+{
+    /* Always leave room for the closing quote */
+    size--;
+    length = ezc_log_appendf(buf, length, size, "\"");
+
+    for (; *str != '\0'; str++)
+    {
+        unsigned char const c = *str;
+        char escaped[8];
+
+        if (c == '"' || c == '\\') sprintf(escaped, "\\%c", c);
+        else if (c == '\n') strcpy(escaped, "\\n");
+        else if (c == '\t') strcpy(escaped, "\\t");
+        else if (c < 0x20) sprintf(escaped, "\\u%04x", c);
+        else escaped[0] = c, escaped[1] = '\0';
+
+        if (length + (long) strlen(escaped) >= size) break;
+        length = ezc_log_appendf(buf, length, size, "%s", escaped);
+    }
+
+    return ezc_log_appendf(buf, length, size + 1, "\"");
+}
+
+
+
+/* Write a record into `buf`, which holds `EZC_LOG_JSON_SIZE` bytes, as a
+ * single line of JSON. Fields become members of their own. Returns the
+ * length of the line. */
+static long ezc_log_format_json(ezc_log_data const *log, char *buf)
+{
+    /* Always leave room for the closing brace and newline */
+    long const SIZE = EZC_LOG_JSON_SIZE - 2;
+    char const *raw = (char const *) (log + 1), *end = raw + log->args;
+    char body[EZC_LOG_BUFFER_SIZE];
+    ezc_log_field field;
+    long length;
+
+    length = ezc_log_appendf(buf, 0, SIZE, "{\"sequence\":%ld,\"time\":%ld,"
+            "\"level\":\"%s\",\"file\":", log->sequence, (long) log->time,
+            EZC_LOG_TAG(log->type));
+    length = ezc_log_json_string(buf, length, SIZE, log->file);
+    length = ezc_log_appendf(buf, length, SIZE, ",\"line\":%ld,\"message\":",
+            log->line);
+
+    if (log->kind == EZC_LOG_KIND_FIELDS)
+    {
+        length = ezc_log_json_string(buf, length, SIZE, log->format);
+
+        while ((raw = ezc_log_field_next(raw, end, &field)) != NULL)
+        {
+            length = ezc_log_appendf(buf, length, SIZE, ",");
+            length = ezc_log_json_string(buf, length, SIZE, field.key);
+            length = ezc_log_appendf(buf, length, SIZE, ":");
+
+            switch (field.type)
+            {
+                case EZC_LOG_FIELD_INT:
+                    length = ezc_log_appendf(buf, length, SIZE, "%ld",
+                            field.i);
+                    break;
+
+                case EZC_LOG_FIELD_DOUBLE:
+                    /* JSON has no NaN or infinity */
+                    if (field.d != field.d || field.d > DBL_MAX ||
+                            field.d < -DBL_MAX)
+                    {
+                        length = ezc_log_appendf(buf, length, SIZE, "null");
+                    }
+                    else
+                    {
+                        length = ezc_log_appendf(buf, length, SIZE, "%.17g",
+                                field.d);
+                    }
+                    break;
+
+                case EZC_LOG_FIELD_STRING:
+                    length = ezc_log_json_string(buf, length, SIZE, field.s);
+                    break;
+
+                default:
+                    length = ezc_log_appendf(buf, length, SIZE, "\"%p\"",
+                            field.p);
+                    break;
+            }
+        }
+    }
+    else
+    {
+        ezc_log_body(log, body, 0);
+        length = ezc_log_json_string(buf, length, SIZE, body);
+    }
+
+    memcpy(buf + length, "}\n", 3);
+    return length + 2;
+}
+
+
+
+
+/* Whether messages have to be formatted right away, to be echoed or written
+ * to a file. */
+static int ezc_log_is_echoed()
+{
+    return EZC_ATOMIC_LOAD(&EZC_LOG_ECHO_DEST) != NULL ||
+        EZC_ATOMIC_LOAD(&EZC_LOG_FILE.file) != NULL ||
+        EZC_ATOMIC_LOAD(&EZC_LOG_SEGMENT) != NULL;
+}
+
+
+
+/* Add a record to the calling thread's log and echo its text, unless
+ * `length` is negative. Aborts after fatal messages. Takes ownership of the
+ * record. */
+static void ezc_log_publish(ezc_log_data *log, ezc_log_t type,
+                            char const *text, long length)
+{
+    ezc_log_thread * const self = ezc_log_thread_get();
+
+    if (self != NULL && log != NULL)
+    {
+        log->sequence = EZC_ATOMIC_ADD(&EZC_LOG_SEQUENCE, 1);
+        log->time = time(NULL);
+
+        pthread_mutex_lock(&self->lock);
+        ezc_log_ring_push(&self->ring, log);
+        pthread_mutex_unlock(&self->lock);
+    }
+    else
+    {
+        ezc_log_data_delete(log);
+    }
+
+    if (length >= 0)
+    {
+        /* Written right away even in asynchronous mode, so that the segment
+         * still holds the message if the process crashes before the writer
+         * thread gets to it */
+        ezc_log_segment_write(text);
+
+        if (!ezc_log_enqueue(text, length)) ezc_log_emit(text);
+    }
+
+    if (type == EZC_LOG_FATAL)
+    {
+        ezc_log_flush();
+        ezc_log_fwrite();
+        abort();
+    }
+}
+
+
+
+void ezc_log__(char const *file, long line,
+               ezc_log_t type, char const *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+
+    ezc_log_data *log = NULL;
+    int binary = 0;
+
+    /* Format everything once into scratch space on the stack, then keep an
+     * exact-size copy. The record and its text share a single allocation. */
+    char buf[EZC_LOG_BUFFER_SIZE];
+    long length = -1;
+
+    /* Binary records only keep the raw arguments around, unless the message
+     * is about to be echoed or written to a file anyway */
+    if (EZC_ATOMIC_LOAD(&EZC_LOG_MODE) == EZC_LOG_MODE_BINARY &&
+            !ezc_log_is_echoed())
+    {
+        long const packed =
+            ezc_log_pack(buf, EZC_LOG_BUFFER_SIZE, message, args);
+
+        if (packed >= 0)
+        {
+            binary = 1;
+            log = ezc_log_data_new(packed);
+
+            if (log != NULL)
+            {
+                log->kind = EZC_LOG_KIND_BINARY;
+                log->message = NULL;
+                log->format = message;
+                log->args = packed;
+                log->size = sizeof *log + packed;
+                memcpy(log + 1, buf, packed);
+            }
+        }
+        else
+        {
+            /* Too big, so format the message after all */
+            va_end(args);
+            va_start(args, message);
+        }
+    }
+
+    if (!binary)
+    {
+        length = ezc_log_header(buf, type, file, line);
+
+        if (length < EZC_LOG_BUFFER_SIZE)
+        {
+            long const written = vsnprintf(buf + length,
+                    EZC_LOG_BUFFER_SIZE - length, message, args);
+
+            if (written > 0) length += written;
+        }
+
+        /* Truncated messages still end with the usual blank line */
+        length = ezc_log_finish(buf, length);
+        log = ezc_log_data_new(length + 1);
+
+        if (log != NULL)
+        {
+            log->kind = EZC_LOG_KIND_TEXT;
+            log->message = (char *) (log + 1);
+            log->format = NULL;
+            log->args = 0;
+            log->size = sizeof *log + length + 1;
+            memcpy(log->message, buf, length + 1);
+        }
+    }
+
+    if (log != NULL)
+    {
+        log->type = type;
+        log->file = file;
+        log->line = line;
+    }
+
+    va_end(args);
+    ezc_log_publish(log, type, buf, length);
+}
+
+
+
+/* Copy the fields in `args` into `buf`, see `ezc_log_field`. Fields that do
+ * not fit are left out. Returns the number of bytes used. */
+static long ezc_log_pack_fields(char *buf, long size, va_list args)
+{
+    long used = 0;
+    int type;
+
+    while ((type = va_arg(args, int)) != EZC_LOG_FIELD_END)
+    {
+        char const * const KEY = va_arg(args, char const *);
+        long const KEY_SIZE = strlen(KEY) + 1;
+        char *at = buf + used + 1 + KEY_SIZE;
+        long value_size;
+
+        switch (type)
+        {
+            case EZC_LOG_FIELD_INT:
+            {
+                long const value = va_arg(args, long);
+                value_size = sizeof value;
+                if (at + value_size > buf + size) return used;
+                memcpy(at, &value, value_size);
+                break;
+            }
+
+            case EZC_LOG_FIELD_DOUBLE:
+            {
+                double const value = va_arg(args, double);
+                value_size = sizeof value;
+                if (at + value_size > buf + size) return used;
+                memcpy(at, &value, value_size);
+                break;
+            }
+
+            case EZC_LOG_FIELD_POINTER:
+            {
+                void const * const value = va_arg(args, void const *);
+                value_size = sizeof value;
+                if (at + value_size > buf + size) return used;
+                memcpy(at, &value, value_size);
+                break;
+            }
+
+            case EZC_LOG_FIELD_STRING:
+            {
+                char const *value = va_arg(args, char const *);
+                if (value == NULL) value = "(null)";
+                value_size = strlen(value) + 1;
+                if (at + value_size > buf + size) return used;
+                memcpy(at, value, value_size);
+                break;
+            }
+
+            default:
+                /* Without knowing its size, nothing after it can be read */
+                return used;
+        }
+
+        buf[used] = (char) type;
+        memcpy(buf + used + 1, KEY, KEY_SIZE);
+        used += 1 + KEY_SIZE + value_size;
+    }
+
+    return used;
+}
+
+
+
+void ezc_log_kv__(char const *file, long line,
+                  ezc_log_t type, char const *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+
+    char buf[EZC_LOG_BUFFER_SIZE];
+    long const PACKED = ezc_log_pack_fields(buf, EZC_LOG_BUFFER_SIZE, args);
+    ezc_log_data *log = ezc_log_data_new(PACKED);
+    long length = -1;
+
+    va_end(args);
+
+    if (log != NULL)
+    {
+        log->type = type;
+        log->kind = EZC_LOG_KIND_FIELDS;
+        log->message = NULL;
+        log->file = file;
+        log->line = line;
+        log->format = message;
+        log->args = PACKED;
+        log->size = sizeof *log + PACKED;
+        memcpy(log + 1, buf, PACKED);
+
+        if (ezc_log_is_echoed()) length = ezc_log_format(log, buf);
+    }
+
+    ezc_log_publish(log, type, buf, length);
+}
+
+
+
+/* Look up the site of the given call. A free slot on the way means the site
+ * is new, in which case it is added there if `add` is set. Adding must only
+ * happen under `EZC_LOG_SITES_LOCK`. */
+static ezc_log_site* ezc_log_site_find(char const *file, long line, int add)
+{
+    unsigned long const HASH = (unsigned long) file * 31 + line;
+    long i;
+
+    for (i = 0; i < EZC_LOG_SITES; i++)
+    {
+        ezc_log_site * const site =
+            &EZC_LOG_SITE_TABLE[(HASH + i) & (EZC_LOG_SITES - 1)];
+        char const * const taken = EZC_ATOMIC_LOAD(&site->file);
+
+        if (taken == NULL)
+        {
+            if (!add) return NULL;
+
+            site->line = line;
+            EZC_ATOMIC_STORE(&site->file, file);
+            return site;
+        }
+
+        if (taken == file && site->line == line) return site;
+    }
+
+    return NULL;
+}
+
+
+
+/* The site of the given call, added on first use. `NULL` if the table is
+ * full. */
+static ezc_log_site* ezc_log_site_get(char const *file, long line)
+{
+    ezc_log_site *site = ezc_log_site_find(file, line, 0);
+
+    if (site == NULL)
+    {
+        pthread_mutex_lock(&EZC_LOG_SITES_LOCK);
+        site = ezc_log_site_find(file, line, 1);
+        pthread_mutex_unlock(&EZC_LOG_SITES_LOCK);
+    }
+
+    return site;
+}
+
+
+
+/* Report what a site dropped since its last summary */
+static void ezc_log_site_report(ezc_log_site *site)
+{
+    long const SUPPRESSED = EZC_ATOMIC_EXCHANGE(&site->suppressed, 0);
+
+    if (SUPPRESSED > 0)
+    {
+        ezc_log__(site->file, site->line, EZC_ATOMIC_LOAD(&site->type),
+                "Suppressed %li similar messages.", SUPPRESSED);
+    }
+}
+
+
+
+/* Report the sites that dropped messages before `now` but have not logged
+ * since, which would otherwise never get to report them. Every second at
+ * most, or right away if `now` is `0`. */
+static void ezc_log_site_sweep(long now)
+{
+    long const SWEPT = EZC_ATOMIC_LOAD(&EZC_LOG_SITES_SWEPT);
+    long i;
+
+    if (now != 0 && (SWEPT == now ||
+                !EZC_ATOMIC_CAS(&EZC_LOG_SITES_SWEPT, SWEPT, now)))
+    {
+        return;
+    }
+
+    for (i = 0; i < EZC_LOG_SITES; i++)
+    {
+        ezc_log_site * const site = &EZC_LOG_SITE_TABLE[i];
+
+        if (EZC_ATOMIC_LOAD(&site->file) != NULL &&
+                EZC_ATOMIC_LOAD(&site->suppressed) > 0 &&
+                (now == 0 || EZC_ATOMIC_LOAD(&site->window) != now))
+        {
+            ezc_log_site_report(site);
+        }
+    }
+}
+
+
+
+int ezc_log_admit__(char const *file, long line, ezc_log_t type)
+{
+    ezc_log_site *site;
+    long now, window, sample;
+
+    if (EZC_ATOMIC_LOAD(&ezc_log_rate__) <= 0) return 1;
+
+    site = ezc_log_site_get(file, line);
+    if (site == NULL) return 1;
+
+    now = time(NULL);
+    window = EZC_ATOMIC_LOAD(&site->window);
+    EZC_ATOMIC_STORE(&site->type, type);
+
+    /* Whoever sees the new second first starts counting anew and reports
+     * what was dropped during the previous ones */
+    if (window != now && EZC_ATOMIC_CAS(&site->window, window, now))
+    {
+        EZC_ATOMIC_STORE(&site->count, 0);
+        ezc_log_site_report(site);
+        ezc_log_site_sweep(now);
+    }
+
+    if (EZC_ATOMIC_ADD(&site->count, 1) < EZC_ATOMIC_LOAD(&ezc_log_rate__))
+    {
+        return 1;
+    }
+
+    sample = EZC_ATOMIC_LOAD(&EZC_LOG_SAMPLE);
+
+    if (sample > 0 && EZC_ATOMIC_ADD(&site->over, 1) % sample == 0)
+    {
+        return 1;
+    }
+
+    EZC_ATOMIC_ADD(&site->suppressed, 1);
+    return 0;
+}
+
+
+
+void ezc_log_allocator(ezc_allocator const *allocator)
+{
+    EZC_ATOMIC_STORE(&EZC_LOG_ALLOCATOR, allocator);
+}
+
+
+
+void ezc_log_echo(FILE *dest)
+{
+    EZC_ATOMIC_STORE(&EZC_LOG_ECHO_DEST, dest);
+}
+
+
+
+void ezc_log_mode(ezc_log_mode_t mode)
+{
+    EZC_ATOMIC_STORE(&EZC_LOG_MODE, mode);
+}
+
+
+
+void ezc_log_rate(long per_second, long sample)
+{
+    EZC_ATOMIC_STORE(&EZC_LOG_SAMPLE, sample);
+    EZC_ATOMIC_STORE(&ezc_log_rate__, per_second);
+}
+
+
+
+void ezc_log_level(ezc_log_t type)
+{
+    ezc_log_level__ = type;
+}
+
+
+
+void ezc_log_async_start(long capacity, ezc_log_full_t full)
+{
+    ezc_log_queue * const queue = &EZC_LOG_QUEUE;
+    static int registered = 0;
+    int running;
+
+    pthread_mutex_lock(&EZC_LOG_QUEUE_LOCK);
+
+    EZC_ATOMIC_STORE(&queue->full, full);
+
+    if (!queue->running && capacity > 0)
+    {
+        long i;
+
+        /* Reuse the cells of a previous run if they are big enough */
+        if (capacity > queue->capacity)
+        {
+            ezc_log_cell *cells;
+            EZC_NEWN(cells, capacity);
+
+            if (cells != NULL)
+            {
+                EZC_MEM_KEEP(cells);
+                EZC_FREE(queue->cells);
+                queue->cells = cells;
+                queue->capacity = capacity;
+            }
+        }
+
+        if (queue->cells != NULL)
+        {
+            for (i = 0; i < queue->capacity; i++)
+            {
+                queue->cells[i].sequence = i;
+                queue->cells[i].message = NULL;
+            }
+
+            queue->enqueue_pos = 0;
+            queue->dequeue_pos = 0;
+            queue->pushed = 0;
+            queue->popped = 0;
+            queue->blocked = 0;
+            queue->sleeping = 0;
+
+            if (!registered)
+            {
+                pthread_mutex_init(&queue->lock, NULL);
+                pthread_cond_init(&queue->wake, NULL);
+                pthread_cond_init(&queue->drained, NULL);
+                pthread_cond_init(&queue->room, NULL);
+            }
+
+            EZC_ATOMIC_STORE(&queue->running, 1);
+
+            if (pthread_create(&queue->writer, NULL, ezc_log_writer, queue))
+            {
+                EZC_ATOMIC_STORE(&queue->running, 0);
+            }
+            else if (!registered)
+            {
+                registered = 1;
+                atexit(ezc_log_async_stop);
+            }
+        }
+    }
+
+    running = queue->running;
+    pthread_mutex_unlock(&EZC_LOG_QUEUE_LOCK);
+
+    if (!running)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to start asynchronous logging.");
+    }
+}
+
+
+
+void ezc_log_async_stop()
+{
+    ezc_log_queue * const queue = &EZC_LOG_QUEUE;
+
+    pthread_mutex_lock(&EZC_LOG_QUEUE_LOCK);
+
+    if (queue->running)
+    {
+        char *message;
+        struct timespec deadline;
+
+        EZC_ATOMIC_EXCHANGE(&queue->running, 0);
+
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_signal(&queue->wake);
+        pthread_cond_broadcast(&queue->room);
+        pthread_mutex_unlock(&queue->lock);
+
+        /* The writer drains whatever is left before exiting, except for
+         * messages from producers that raced with us. Wait for those to
+         * finish pushing, then drain again so nothing is left behind for the
+         * next start to throw away. */
+        pthread_join(queue->writer, NULL);
+
+        pthread_mutex_lock(&queue->lock);
+
+        while (EZC_ATOMIC_LOAD(&queue->producers) > 0)
+        {
+            ezc_log_deadline(&deadline, EZC_LOG_POLL_MS);
+            pthread_cond_timedwait(&queue->drained, &queue->lock, &deadline);
+        }
+
+        pthread_mutex_unlock(&queue->lock);
+
+        while ((message = ezc_log_queue_pop(queue)) != NULL)
+        {
+            ezc_log_emit(message);
+            EZC_FREE(message);
+        }
+    }
+
+    pthread_mutex_unlock(&EZC_LOG_QUEUE_LOCK);
+}
+
+
+
+void ezc_log_flush()
+{
+    ezc_log_queue * const queue = &EZC_LOG_QUEUE;
+    FILE *dest;
+
+    ezc_log_site_sweep(0);
+
+    if (EZC_ATOMIC_LOAD(&queue->running))
+    {
+        long const target = EZC_ATOMIC_LOAD(&queue->pushed);
+        struct timespec deadline;
+
+        pthread_mutex_lock(&queue->lock);
+
+        while (EZC_ATOMIC_LOAD(&queue->running) &&
+                EZC_ATOMIC_LOAD(&queue->popped) < target)
+        {
+            ezc_log_deadline(&deadline, EZC_LOG_POLL_MS);
+            pthread_cond_timedwait(&queue->drained, &queue->lock, &deadline);
+        }
+
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    dest = EZC_ATOMIC_LOAD(&EZC_LOG_ECHO_DEST);
+    if (dest != NULL) fflush(dest);
+
+    pthread_mutex_lock(&EZC_LOG_FILE_LOCK);
+    if (EZC_LOG_FILE.file != NULL) fflush(EZC_LOG_FILE.file);
+    pthread_mutex_unlock(&EZC_LOG_FILE_LOCK);
+}
+
+
+
+int ezc_log_file_open(char const *path, long max_bytes, long max_seconds,
+                      ezc_log_sync_t sync)
+{
+    assert(path != NULL);
+
+    ezc_log_file * const sink = &EZC_LOG_FILE;
+    char *copy;
+    int opened;
+
+    ezc_log_file_close();
+
+    EZC_NEWN(copy, strlen(path) + 1);
+    if (copy != NULL) strcpy(copy, path);
+
+    pthread_mutex_lock(&EZC_LOG_FILE_LOCK);
+
+    sink->path = copy;
+    sink->sync = sync;
+    sink->max_bytes = (max_bytes > 0 ? max_bytes : 0);
+    sink->max_seconds = (max_seconds > 0 ? max_seconds : 0);
+
+    if (copy != NULL) ezc_log_file_reopen(sink);
+    opened = (sink->file != NULL);
+
+    pthread_mutex_unlock(&EZC_LOG_FILE_LOCK);
+
+    if (!opened)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to open log file \"%s\".", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+int ezc_log_segment_open(char const *path, long size)
+{
+    assert(path != NULL && size > 0);
+
+    ezc_log_segment * const segment = &EZC_LOG_SEGMENTS[0];
+    int opened = 0;
+
+    ezc_log_segment_close();
+
+    pthread_mutex_lock(&EZC_LOG_SEGMENT_LOCK);
+
+    EZC_NEWN(EZC_LOG_SEGMENT_PATH, strlen(path) + 1);
+
+    if (EZC_LOG_SEGMENT_PATH != NULL)
+    {
+        strcpy(EZC_LOG_SEGMENT_PATH, path);
+        opened = ezc_log_segment_map(segment, size);
+    }
+
+    if (opened) EZC_ATOMIC_STORE(&EZC_LOG_SEGMENT, segment);
+
+    pthread_mutex_unlock(&EZC_LOG_SEGMENT_LOCK);
+
+    if (!opened)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to map log segment \"%s\".", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+void ezc_log_segment_close()
+{
+    pthread_mutex_lock(&EZC_LOG_SEGMENT_LOCK);
+
+    if (EZC_LOG_SEGMENT != NULL)
+    {
+        ezc_log_segment * const segment = EZC_LOG_SEGMENT;
+
+        EZC_ATOMIC_STORE(&EZC_LOG_SEGMENT, (ezc_log_segment *) NULL);
+        ezc_log_segment_unmap(segment);
+    }
+
+    EZC_FREE(EZC_LOG_SEGMENT_PATH);
+
+    pthread_mutex_unlock(&EZC_LOG_SEGMENT_LOCK);
+}
+
+
+
+void ezc_log_file_close()
+{
+    ezc_log_file * const sink = &EZC_LOG_FILE;
+
+    pthread_mutex_lock(&EZC_LOG_FILE_LOCK);
+
+    if (sink->file != NULL)
+    {
+        fclose(sink->file);
+        EZC_ATOMIC_STORE(&sink->file, (FILE *) NULL);
+    }
+
+    EZC_FREE(sink->path);
+
+    pthread_mutex_unlock(&EZC_LOG_FILE_LOCK);
+}
+
+
+
+void ezc_log_capacity(long records, long bytes)
+{
+    ezc_log_thread *iter;
+    int failed = 0;
+
+    if (records <= 0) records = EZC_LOG_DEFAULT_RECORDS;
+    if (bytes < 0) bytes = 0;
+
+    EZC_ATOMIC_STORE(&EZC_LOG_RECORDS, records);
+    EZC_ATOMIC_STORE(&EZC_LOG_BYTES, bytes);
+
+    for (iter = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS); iter != NULL;
+            iter = iter->next)
+    {
+        pthread_mutex_lock(&iter->lock);
+        failed |= !ezc_log_ring_resize(&iter->ring, records, bytes);
+        pthread_mutex_unlock(&iter->lock);
+    }
+
+    if (failed)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to resize log to %li records.",
+                records);
+    }
+}
+
+
+
+char const* ezc_log_get(ezc_log_t type)
+{
+    ezc_log_thread * const self = ezc_log_thread_get();
+    ezc_log_thread *iter;
+    long best = -1;
+
+    if (self == NULL) return NULL;
+
+    for (iter = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS); iter != NULL;
+            iter = iter->next)
+    {
+        ezc_log_ring const * const ring = &iter->ring;
+        ezc_log_data const *newest = NULL;
+        int level;
+
+        pthread_mutex_lock(&iter->lock);
+
+        if (type > EZC_LOG_FATAL)
+        {
+            /* Such types share the index of fatal logs, so search */
+            long n;
+
+            for (n = 0; n < ring->length && newest == NULL; n++)
+            {
+                ezc_log_data const * const log = EZC_LOG_RING_AT(ring, n);
+                if (log->type >= type) newest = log;
+            }
+        }
+        else
+        {
+            for (level = EZC_LOG_LEVEL_OF(type); level < EZC_LOG_LEVELS;
+                    level++)
+            {
+                ezc_log_data const * const log =
+                    ezc_log_ring_latest(ring, level);
+
+                if (log != NULL && log->type >= type &&
+                        (newest == NULL || log->sequence > newest->sequence))
+                {
+                    newest = log;
+                }
+            }
+        }
+
+        /* Copy while the owner cannot discard the record */
+        if (newest != NULL && newest->sequence > best)
+        {
+            char buf[EZC_LOG_BUFFER_SIZE];
+            long const LENGTH = ezc_log_format(newest, buf);
+            char *got = EZC_MEM_REALLOC(EZC_MEM_GLOBAL, self->got,
+                    LENGTH + 1);
+
+            if (got != NULL)
+            {
+                EZC_MEM_KEEP(got);
+                memcpy(got, buf, LENGTH + 1);
+                self->got = got;
+                best = newest->sequence;
+            }
+        }
+
+        pthread_mutex_unlock(&iter->lock);
+    }
+
+    return best < 0 ? NULL : self->got;
+}
+
+
+
+struct ezc_log_query
+{
+    ezc_log_t min, max;
+    char const *file;
+    time_t since, until;
+
+    /* Threads whose logs are visited, and the levels to visit. Nothing
+     * logged after the query began is visited. */
+    ezc_log_thread **threads;
+    long count;
+    int first, last;
+
+    /* For each thread and level, the number of the next record to visit and
+     * its sequence, or -1 once there is none */
+    long *cursors, *sequences;
+
+    /* Copy of the record visited last, with room for its text or arguments */
+    ezc_log_data *copy;
+
+    ezc_log_record record;
+    char buf[EZC_LOG_BUFFER_SIZE];
+};
+
+
+
+/* Cursor of the given thread and level. */
+#define EZC_LOG_QUERY_SLOT(i, level) \
+    ((i) * EZC_LOG_LEVELS + (level))
+
+
+
+/* Look up the record at a cursor and note its sequence. The thread's lock
+ * must be held. */
+static ezc_log_data* ezc_log_query_peek(ezc_log_query *self,
+                                       ezc_log_ring const *ring, long slot)
+{
+    ezc_log_data * const log = ezc_log_ring_numbered(ring,
+            self->cursors[slot]);
+
+    self->sequences[slot] = (log != NULL ? log->sequence : -1);
+    return log;
+}
+
+
+
+/* Start visiting the records of the levels from `first` to `last`. Threads
+ * are only locked one at a time and only briefly, so they can keep logging
+ * meanwhile, and so can the caller. */
+static ezc_log_query* ezc_log_query_begin(int first, int last)
+{
+    /* Threads are only ever pushed to the front of the list */
+    ezc_log_thread * const head = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS);
+    ezc_log_query *self;
+    ezc_log_thread *iter;
+    long i, count = 0;
+    int level;
+
+    EZC_NEW0(self);
+    if (self == NULL) return NULL;
+
+    for (iter = head; iter != NULL; iter = iter->next) count++;
+
+    self->count = count;
+    self->first = first;
+    self->last = last;
+
+    EZC_NEWN(self->threads, count > 0 ? count : 1);
+    EZC_NEWN(self->cursors, count > 0 ? count * EZC_LOG_LEVELS : 1);
+    EZC_NEWN(self->sequences, count > 0 ? count * EZC_LOG_LEVELS : 1);
+    self->copy = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, sizeof(ezc_log_data) +
+            EZC_LOG_BUFFER_SIZE);
+
+    if (self->threads == NULL || self->cursors == NULL ||
+            self->sequences == NULL || self->copy == NULL)
+    {
+        EZC_FREE(self->threads, self->cursors, self->sequences, self->copy);
+        EZC_FREE(self);
+        return NULL;
+    }
+
+    for (i = 0, iter = head; i < count; i++, iter = iter->next)
+    {
+        self->threads[i] = iter;
+        pthread_mutex_lock(&iter->lock);
+
+        for (level = 0; level < EZC_LOG_LEVELS; level++)
+        {
+            long const SLOT = EZC_LOG_QUERY_SLOT(i, level);
+
+            self->sequences[SLOT] = -1;
+
+            if (level >= first && level <= last)
+            {
+                self->cursors[SLOT] = iter->ring.latest[level];
+                ezc_log_query_peek(self, &iter->ring, SLOT);
+            }
+        }
+
+        pthread_mutex_unlock(&iter->lock);
+    }
+
+    return self;
+}
+
+
+
+/* Copy of the next record of any thread, newest first, which stays valid
+ * until the next step. Records that their thread discards before they are
+ * reached are skipped. */
+static ezc_log_data const* ezc_log_query_step(ezc_log_query *self)
+{
+    for (;;)
+    {
+        ezc_log_thread *thread;
+        ezc_log_data *log;
+        long slot, pick = -1;
+
+        /* There are few threads and levels compared to records, so picking
+         * the newest cursor linearly is fine */
+        for (slot = 0; slot < self->count * EZC_LOG_LEVELS; slot++)
+        {
+            if (self->sequences[slot] >= 0 && (pick < 0 ||
+                        self->sequences[slot] > self->sequences[pick]))
+            {
+                pick = slot;
+            }
+        }
+
+        if (pick < 0) return NULL;
+
+        thread = self->threads[pick / EZC_LOG_LEVELS];
+        pthread_mutex_lock(&thread->lock);
+
+        if ((log = ezc_log_ring_numbered(&thread->ring,
+                        self->cursors[pick])) != NULL)
+        {
+            /* The text of text records is the only thing pointed into */
+            memcpy(self->copy, log, log->size);
+            if (log->message != NULL)
+            {
+                self->copy->message = (char *) (self->copy + 1);
+            }
+
+            self->cursors[pick] = log->previous;
+            ezc_log_query_peek(self, &thread->ring, pick);
+            pthread_mutex_unlock(&thread->lock);
+
+            return self->copy;
+        }
+
+        /* Older records of the thread are gone as well */
+        self->sequences[pick] = -1;
+        pthread_mutex_unlock(&thread->lock);
+    }
+}
+
+
+
+static void ezc_log_query_end(ezc_log_query *self)
+{
+    EZC_FREE(self->threads, self->cursors, self->sequences, self->copy);
+    EZC_FREE(self);
+}
+
+
+
+ezc_log_query* ezc_log_query_new(ezc_log_t min, ezc_log_t max,
+                                 char const *file, time_t since, time_t until)
+{
+    ezc_log_query * const self = ezc_log_query_begin(EZC_LOG_LEVEL_OF(min),
+            EZC_LOG_LEVEL_OF(max));
+
+    if (self != NULL)
+    {
+        self->min = min;
+        self->max = max;
+        self->file = file;
+        self->since = since;
+        self->until = until;
+    }
+    else
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to query log.");
+    }
+
+    return self;
+}
+
+
+
+ezc_log_record const* ezc_log_query_next(ezc_log_query *self)
+{
+    assert(self != NULL);
+
+    ezc_log_data const *log;
+
+    while ((log = ezc_log_query_step(self)) != NULL)
+    {
+        if (log->type < self->min || log->type > self->max ||
+                log->time < self->since ||
+                (self->until > 0 && log->time > self->until) ||
+                (self->file != NULL && log->file != self->file &&
+                 strcmp(log->file, self->file) != 0))
+        {
+            continue;
+        }
+
+        self->record.type = log->type;
+        self->record.file = log->file;
+        self->record.line = log->line;
+        self->record.time = log->time;
+
+        /* Binary records are formatted into the query's own buffer */
+        if (log->message != NULL)
+        {
+            self->record.message = log->message;
+        }
+        else
+        {
+            ezc_log_format(log, self->buf);
+            self->record.message = self->buf;
+        }
+
+        return &self->record;
+    }
+
+    return NULL;
+}
+
+
+
+void ezc_log_query_delete__(ezc_log_query *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        ezc_log_query_end(self);
+        self = va_arg(arg_ptr, ezc_log_query*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_log_fwrite()
+{
+    time_t rawtime;
+    struct tm *infotime;
+
+    time(&rawtime);
+    infotime = localtime(&rawtime);
+
+    char stem[32], buf[64];
+    strftime(stem, sizeof stem, "%Y-%m-%d-%H-%M-%S", infotime);
+
+    /* Never overwrite the log written earlier within the same second */
+    FILE *file = ezc_log_fcreate(buf, sizeof buf, stem, ".error");
+
+    ezc_log_query *query;
+
+    if (file != NULL)
+    {
+        if ((query = ezc_log_query_begin(0, EZC_LOG_LEVELS - 1)) != NULL)
+        {
+            ezc_log_data const *log;
+
+            while ((log = ezc_log_query_step(query)) != NULL)
+            {
+                fwrite(query->buf, sizeof(char),
+                        ezc_log_format(log, query->buf), file);
+            }
+
+            ezc_log_query_end(query);
+        }
+
+        fclose(file);
+    }
+    else
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to write log to file. "
+                "Error while opening/creating file.");
+    }
+}
+
+
+
+/* Each record is dumped as a header of longs, followed by its text, raw
+ * arguments or fields, its file name and, unless it is text, its format
+ * string or message. */
+enum
+{
+    EZC_LOG_DUMP_KIND = 0,
+    EZC_LOG_DUMP_TYPE,
+    EZC_LOG_DUMP_SEQUENCE,
+    EZC_LOG_DUMP_TIME,
+    EZC_LOG_DUMP_LINE,
+    EZC_LOG_DUMP_PAYLOAD,
+    EZC_LOG_DUMP_FILE,
+    EZC_LOG_DUMP_FORMAT,
+    EZC_LOG_DUMP_HEADER
+};
+
+
+
+static void ezc_log_dump_record(ezc_log_data const *log, FILE *dest)
+{
+    long header[EZC_LOG_DUMP_HEADER];
+    int const binary = (log->kind != EZC_LOG_KIND_TEXT);
+
+    header[EZC_LOG_DUMP_KIND] = log->kind;
+    header[EZC_LOG_DUMP_TYPE] = log->type;
+    header[EZC_LOG_DUMP_SEQUENCE] = log->sequence;
+    header[EZC_LOG_DUMP_TIME] = (long) log->time;
+    header[EZC_LOG_DUMP_LINE] = log->line;
+    header[EZC_LOG_DUMP_PAYLOAD] =
+        (binary ? log->args : (long) strlen(log->message));
+    header[EZC_LOG_DUMP_FILE] = strlen(log->file);
+    header[EZC_LOG_DUMP_FORMAT] = (binary ? (long) strlen(log->format) : 0);
+
+    if (header[EZC_LOG_DUMP_FILE] > EZC_LOG_DUMP_STRING)
+    {
+        header[EZC_LOG_DUMP_FILE] = EZC_LOG_DUMP_STRING;
+    }
+
+    if (header[EZC_LOG_DUMP_FORMAT] > EZC_LOG_DUMP_STRING)
+    {
+        header[EZC_LOG_DUMP_FORMAT] = EZC_LOG_DUMP_STRING;
+    }
+
+    fwrite(header, sizeof(long), EZC_LOG_DUMP_HEADER, dest);
+    fwrite(log + 1, sizeof(char), header[EZC_LOG_DUMP_PAYLOAD], dest);
+    fwrite(log->file, sizeof(char), header[EZC_LOG_DUMP_FILE], dest);
+
+    if (binary)
+    {
+        fwrite(log->format, sizeof(char), header[EZC_LOG_DUMP_FORMAT], dest);
+    }
+}
+
+
+
+void ezc_log_fwrite_json(FILE *dest)
+{
+    assert(dest != NULL);
+
+    ezc_log_query *query = ezc_log_query_begin(0, EZC_LOG_LEVELS - 1);
+    char *buf;
+
+    EZC_NEWN(buf, EZC_LOG_JSON_SIZE);
+
+    if (query != NULL && buf != NULL)
+    {
+        ezc_log_data const *log;
+
+        while ((log = ezc_log_query_step(query)) != NULL)
+        {
+            fwrite(buf, sizeof(char), ezc_log_format_json(log, buf), dest);
+        }
+    }
+
+    if (query != NULL) ezc_log_query_end(query);
+    EZC_FREE(buf);
+}
+
+
+
+void ezc_log_dump(FILE *dest)
+{
+    assert(dest != NULL);
+
+    ezc_log_query *query;
+
+    fputs(EZC_LOG_DUMP_MAGIC, dest);
+
+    if ((query = ezc_log_query_begin(0, EZC_LOG_LEVELS - 1)) != NULL)
+    {
+        ezc_log_data const *log;
+
+        while ((log = ezc_log_query_step(query)) != NULL)
+        {
+            ezc_log_dump_record(log, dest);
+        }
+
+        ezc_log_query_end(query);
+    }
+}
+
+
+
+/* Read records dumped by `ezc_log_dump` and write them out using `format`,
+ * whose buffer holds `size` bytes. */
+static long ezc_log_decode_as(FILE *src, FILE *dest,
+                              long (*format)(ezc_log_data const *, char *),
+                              long size)
+{
+    assert(src != NULL && dest != NULL);
+
+    char magic[sizeof EZC_LOG_DUMP_MAGIC - 1];
+    long header[EZC_LOG_DUMP_HEADER];
+    long decoded = 0;
+    char *buf;
+
+    if (fread(magic, sizeof(char), sizeof magic, src) != sizeof magic ||
+            memcmp(magic, EZC_LOG_DUMP_MAGIC, sizeof magic) != 0)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to decode log. Not a log dump.");
+        return -1;
+    }
+
+    EZC_NEWN(buf, size);
+
+    while (buf != NULL && fread(header, sizeof(long), EZC_LOG_DUMP_HEADER,
+                src) == EZC_LOG_DUMP_HEADER)
+    {
+        long const KIND = header[EZC_LOG_DUMP_KIND];
+        long const PAYLOAD = header[EZC_LOG_DUMP_PAYLOAD];
+        long const FILE_LENGTH = header[EZC_LOG_DUMP_FILE];
+        long const FORMAT_LENGTH = header[EZC_LOG_DUMP_FORMAT];
+        ezc_log_data *log = NULL;
+        char *payload, *file, *message;
+
+        /* Lay the record out in memory just like `ezc_log__` would have.
+         * Text is copied whole, so it must leave room for its terminator. */
+        if (KIND >= EZC_LOG_KIND_TEXT && KIND <= EZC_LOG_KIND_FIELDS &&
+                PAYLOAD >= 0 && PAYLOAD <= EZC_LOG_BUFFER_SIZE &&
+                (KIND != EZC_LOG_KIND_TEXT || PAYLOAD < EZC_LOG_BUFFER_SIZE) &&
+                FILE_LENGTH >= 0 && FILE_LENGTH <= EZC_LOG_DUMP_STRING &&
+                FORMAT_LENGTH >= 0 && FORMAT_LENGTH <= EZC_LOG_DUMP_STRING)
+        {
+            log = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, sizeof *log + PAYLOAD +
+                    FILE_LENGTH + FORMAT_LENGTH + 3);
+        }
+
+        if (log == NULL)
+        {
+            EZC_FREE(buf);
+            ezc_log(EZC_LOG_ERROR, "Unable to decode log record #%li.",
+                    decoded);
+            return -1;
+        }
+
+        payload = (char *) (log + 1);
+        file = payload + PAYLOAD + 1;
+        message = file + FILE_LENGTH + 1;
+
+        if (fread(payload, sizeof(char), PAYLOAD, src) != (size_t) PAYLOAD ||
+                fread(file, sizeof(char), FILE_LENGTH, src) !=
+                (size_t) FILE_LENGTH ||
+                fread(message, sizeof(char), FORMAT_LENGTH, src) !=
+                (size_t) FORMAT_LENGTH)
+        {
+            EZC_FREE(log, buf);
+            ezc_log(EZC_LOG_ERROR, "Unable to decode log record #%li. "
+                    "Dump is truncated.", decoded);
+            return -1;
+        }
+
+        payload[PAYLOAD] = file[FILE_LENGTH] = message[FORMAT_LENGTH] = '\0';
+
+        log->type = header[EZC_LOG_DUMP_TYPE];
+        log->kind = KIND;
+        log->message = (KIND == EZC_LOG_KIND_TEXT ? payload : NULL);
+        log->file = file;
+        log->line = header[EZC_LOG_DUMP_LINE];
+        log->format = message;
+        log->args = PAYLOAD;
+        log->size = 0;
+        log->sequence = header[EZC_LOG_DUMP_SEQUENCE];
+        log->time = (time_t) header[EZC_LOG_DUMP_TIME];
+
+        fwrite(buf, sizeof(char), (*format)(log, buf), dest);
+        EZC_FREE(log);
+        decoded++;
+    }
+
+    EZC_FREE(buf);
+    return decoded;
+}
+
+
+
+long ezc_log_decode(FILE *src, FILE *dest)
+{
+    return ezc_log_decode_as(src, dest, ezc_log_format, EZC_LOG_BUFFER_SIZE);
+}
+
+
+
+long ezc_log_decode_json(FILE *src, FILE *dest)
+{
+    return ezc_log_decode_as(src, dest, ezc_log_format_json,
+            EZC_LOG_JSON_SIZE);
+}
+
+
+
+void ezc_log_clear()
+{
+    ezc_log_thread *iter;
+
+    for (iter = EZC_ATOMIC_LOAD(&EZC_LOG_THREADS); iter != NULL;
+            iter = iter->next)
+    {
+        pthread_mutex_lock(&iter->lock);
+
+        while (iter->ring.length > 0)
+        {
+            ezc_log_ring_pop(&iter->ring);
+        }
+
+        pthread_mutex_unlock(&iter->lock);
+    }
 }
@@ -31,8 +31,12 @@ extern C
 {
 #endif
 
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+
 #include <stdarg.h>
 #include <stdio.h>
+#include <time.h>
 
 
 
@@ -57,23 +61,269 @@ ezc_log_t;
 
 
 
+/** @brief      What to do when the asynchronous log queue is full.
+ *  @details    See `ezc_log_async_start`.
+ */
+typedef enum ezc_log_full_t
+{
+    /** Wait until the writer thread has made room. Nothing is lost. */
+    EZC_LOG_FULL_BLOCK = 0,
+
+    /** Discard the message being logged. */
+    EZC_LOG_FULL_DROP,
+
+    /** Discard the oldest message still waiting in the queue. */
+    EZC_LOG_FULL_DROP_OLDEST
+}
+ezc_log_full_t;
+
+
+
+/** @brief      How messages are stored in the global log.
+ *  @details    See `ezc_log_mode`.
+ */
+typedef enum ezc_log_mode_t
+{
+    /** Format messages right away. */
+    EZC_LOG_MODE_TEXT = 0,
+
+    /** Keep the raw arguments and format messages only when read. */
+    EZC_LOG_MODE_BINARY
+}
+ezc_log_mode_t;
+
+
+
+/** @brief      How hard the log file tries to get messages onto disk.
+ *  @details    See `ezc_log_file_open`.
+ */
+typedef enum ezc_log_sync_t
+{
+    /** Write through a large buffer. Messages reach the file once the
+     *  buffer fills up, on `ezc_log_flush`, on rotation and on close. */
+    EZC_LOG_SYNC_BUFFERED = 0,
+
+    /** Hand every message over to the OS right away. Nothing is lost if
+     *  the program crashes. */
+    EZC_LOG_SYNC_FLUSH,
+
+    /** Also wait for every message to reach the disk. Nothing is lost even
+     *  if the machine crashes, but logging gets much slower. */
+    EZC_LOG_SYNC_FSYNC
+}
+ezc_log_sync_t;
+
+
+
+/** @brief      Type of a value attached to a message by `ezc_log_kv`.
+ *  @details    Use the `EZC_LOG_INT` and friends macros rather than these.
+ */
+typedef enum ezc_log_field_t
+{
+    /** Ends the list of fields. Added by `ezc_log_kv` itself. */
+    EZC_LOG_FIELD_END = 0,
+
+    /** Stored as `long`. */
+    EZC_LOG_FIELD_INT,
+
+    /** Stored as `double`. */
+    EZC_LOG_FIELD_DOUBLE,
+
+    /** Copied whole, just like the key. */
+    EZC_LOG_FIELD_STRING,
+
+    /** Stored by address only. */
+    EZC_LOG_FIELD_POINTER
+}
+ezc_log_field_t;
+
+
+
+/** @brief      A message in the global log, as seen by `ezc_log_query`.
+ */
+typedef struct ezc_log_record
+{
+    /** Severity. */
+    ezc_log_t type;
+
+    /** Source file and line it was logged from. */
+    char const *file;
+    long line;
+
+    /** When it was logged. */
+    time_t time;
+
+    /** The message, formatted just like `ezc_log_get` returns it. */
+    char const *message;
+}
+ezc_log_record;
+
+
+
+/** @brief      Iterator over the global log. See `ezc_log_query_new`.
+ */
+typedef struct ezc_log_query ezc_log_query;
+
+
+
+/** @brief      Least severe log type compiled into the program.
+ *  @details    Define this before including `ezc_log.h`, or on the command
+ *              line, e.g. `-DEZC_LOG_MIN_LEVEL=EZC_LOG_WARN`. Less severe
+ *              `ezc_log` calls compile to nothing and do not evaluate their
+ *              arguments. `EZC_LOG_FATAL` logs are never filtered out.
+ */
+#ifndef EZC_LOG_MIN_LEVEL
+#define EZC_LOG_MIN_LEVEL EZC_LOG_INFO
+#endif
+
+
+
 /** @brief      Add message to global log.
  *  @details    This macro accepts variadic arguments `printf` style. Messages
  *              are not echoed to `stdout` or `stderr` by default, but this can
- *              be changed via `ezc_log_echo(FILE *)`.
+ *              be changed via `ezc_log_echo(FILE *)`. Safe to call from any
+ *              number of threads at once: each thread records into its own
+ *              buffer, and the buffers together make up the global log.
+ *              Messages less severe than `EZC_LOG_MIN_LEVEL` or
+ *              `ezc_log_level` are skipped before their arguments are
+ *              evaluated, and so are messages over the call site's rate limit,
+ *              see `ezc_log_rate`.
  *  @param      type        The message type enum. See `ezc_log_t`
- *                          documentation for more info.
+ *                          documentation for more info. May be evaluated
+ *                          more than once.
  *  @param      message     The message itself. Supports formatting just like
  *                          `printf`.
  *  @param      ...         `printf` style variadic arguments.
  *  @returns    N/A
  */
 #define ezc_log(type, message, ...) \
-    (ezc_log__(__FILE__, __LINE__, (type), (message), ##__VA_ARGS__))
+    (EZC_LOG_ADMIT__((type)) ? \
+     ezc_log__(__FILE__, __LINE__, (type), (message), ##__VA_ARGS__) : \
+     (void) 0)
+
+
+
+/** @brief      Add message with key/value fields to global log.
+ *  @details    Works just like `ezc_log`, except that `message` is taken as
+ *              is and is followed by fields, e.g.
+ *              `ezc_log_kv(EZC_LOG_WARN, "Slow request.",
+ *              EZC_LOG_STRING("path", path), EZC_LOG_INT("ms", ms));`.
+ *              Nothing is formatted when logging: the fields are packed
+ *              into the record as raw values, keys and strings included.
+ *              Text output renders them as ` key=value` after the message,
+ *              and `ezc_log_fwrite_json` as members of their own. Fields
+ *              that do not fit in 4096 bytes are left out. `message` must
+ *              be a string literal.
+ *  @param      type        The message type enum. See `ezc_log_t`.
+ *  @param      message     The message itself. Not a format string.
+ *  @param      ...         Fields made by `EZC_LOG_INT`, `EZC_LOG_DOUBLE`,
+ *                          `EZC_LOG_STRING` or `EZC_LOG_POINTER`.
+ *  @returns    N/A
+ */
+#define ezc_log_kv(type, message, ...) \
+    (EZC_LOG_ADMIT__((type)) ? \
+     ezc_log_kv__(__FILE__, __LINE__, (type), (message), ##__VA_ARGS__, \
+                  EZC_LOG_FIELD_END) : \
+     (void) 0)
+
+
+
+/** @brief      Integer field for `ezc_log_kv`.
+ *  @param      key     Name of the field.
+ *  @param      value   Any integer. Stored as `long`.
+ */
+#define EZC_LOG_INT(key, value) \
+    EZC_LOG_FIELD_INT, (char const *) (key), (long) (value)
+
+/** @brief      Floating point field for `ezc_log_kv`.
+ *  @param      key     Name of the field.
+ *  @param      value   Any number. Stored as `double`.
+ */
+#define EZC_LOG_DOUBLE(key, value) \
+    EZC_LOG_FIELD_DOUBLE, (char const *) (key), (double) (value)
+
+/** @brief      String field for `ezc_log_kv`.
+ *  @param      key     Name of the field.
+ *  @param      value   The string. Copied whole.
+ */
+#define EZC_LOG_STRING(key, value) \
+    EZC_LOG_FIELD_STRING, (char const *) (key), (char const *) (value)
+
+/** @brief      Pointer field for `ezc_log_kv`.
+ *  @param      key     Name of the field.
+ *  @param      value   Any pointer. Only its address is kept.
+ */
+#define EZC_LOG_POINTER(key, value) \
+    EZC_LOG_FIELD_POINTER, (char const *) (key), (void const *) (value)
+
+
+
+/* Whether a message of `type` from the call site `site` gets logged */
+#define EZC_LOG_ADMIT__(type) \
+    ((type) == EZC_LOG_FATAL || \
+     ((type) >= EZC_LOG_MIN_LEVEL && (type) >= ezc_log_level__ && \
+      (ezc_log_rate__ <= 0 || ezc_log_admit__(__FILE__, __LINE__, (type)))))
 
 void ezc_log__(char const *file, long line, ezc_log_t type,
                char const *message, ...);
 
+void ezc_log_kv__(char const *file, long line, ezc_log_t type,
+                  char const *message, ...);
+
+int ezc_log_admit__(char const *file, long line, ezc_log_t type);
+
+extern ezc_log_t ezc_log_level__;
+extern long ezc_log_rate__;
+
+
+
+/** @brief      Limit how many messages each call site may log per second.
+ *  @details    Once an `ezc_log` call has logged `per_second` messages
+ *              within the current second, further messages from it are
+ *              dropped before anything is formatted, except for every
+ *              `sample`-th one. A summary of how many were dropped is logged
+ *              once the second is over, as soon as any limited call logs
+ *              again, and by `ezc_log_flush`. Calls are told apart by file
+ *              and line, and up to 4096 of them are limited. `EZC_LOG_FATAL`
+ *              messages are never dropped. Meant to be set while no other
+ *              thread is logging.
+ *  @param      per_second  Messages per call site per second. `0` or less
+ *                          turns rate limiting off, which is the default.
+ *  @param      sample      Keep one in `sample` messages over the limit.
+ *                          `0` or less drops them all.
+ */
+void ezc_log_rate(long per_second, long sample);
+
+
+
+/** @brief      Choose how messages are stored in the global log.
+ *  @details    In binary mode `ezc_log` does not format anything. It only
+ *              records the format string and file name by address, the line,
+ *              a timestamp and a raw copy of the arguments (`%s` strings are
+ *              copied whole). Messages get formatted once they are read by
+ *              `ezc_log_get` or `ezc_log_fwrite`, or offline from a dump by
+ *              `ezc_log_decode`. Format strings must therefore be string
+ *              literals. `%n` is ignored, and messages whose arguments do
+ *              not fit in 4096 bytes are formatted right away. While
+ *              messages are being echoed, they are formatted right away as
+ *              well. Defaults to `EZC_LOG_MODE_TEXT`.
+ *  @param      mode        See `ezc_log_mode_t`.
+ */
+void ezc_log_mode(ezc_log_mode_t mode);
+
+
+
+/** @brief      Set the least severe log type that gets logged.
+ *  @details    Checked by `ezc_log` before anything is formatted, so skipped
+ *              messages cost a single comparison. Defaults to
+ *              `EZC_LOG_INFO`, i.e. everything is logged. Has no effect on
+ *              messages already filtered out by `EZC_LOG_MIN_LEVEL`, nor on
+ *              `EZC_LOG_FATAL` messages. Meant to be set while no other
+ *              thread is logging, e.g. at startup.
+ *  @param      type        Least severe type to log.
+ */
+void ezc_log_level(ezc_log_t type);
+
 
 
 /** @brief      Set where logs are echoed to.
@@ -85,34 +335,255 @@ void ezc_log_echo(FILE *dest);
 
 
 
+/** @brief      Append logs to a file as they are logged.
+ *  @details    Unlike `ezc_log_fwrite`, messages are written one by one as
+ *              they come in, oldest first, and the file keeps growing
+ *              independently of the global log. Existing files are appended
+ *              to. Once the file would grow past `max_bytes`, or once it has
+ *              been open for `max_seconds`, it is renamed to
+ *              `path.YYYY-MM-DD-HH-MM-SS` and a new file is started. When
+ *              logging asynchronously, the writer thread does the writing.
+ *              Opening another file closes the current one.
+ *  @param      path        Where to write the log.
+ *  @param      max_bytes   Size at which to rotate. `0` for never.
+ *  @param      max_seconds Age at which to rotate. `0` for never.
+ *  @param      sync        See `ezc_log_sync_t`.
+ *  @returns    `0` on success, or `-1` if the file could not be opened.
+ */
+int ezc_log_file_open(char const *path, long max_bytes, long max_seconds,
+                      ezc_log_sync_t sync);
+
+
+
+/** @brief      Stop appending logs to a file.
+ *  @details    Flushes and closes the file opened by `ezc_log_file_open`.
+ */
+void ezc_log_file_close();
+
+
+
+/** @brief      Copy logs into memory-mapped files as they are logged.
+ *  @details    A file of `size` bytes is preallocated and mapped into memory.
+ *              Logging a message then costs a single `memcpy`, without any
+ *              system call, and the message survives the program crashing
+ *              or aborting. This holds in asynchronous mode too, since
+ *              messages are copied by the logging thread itself rather than
+ *              the writer thread. Once the file is full, logging moves on to
+ *              a new one. Files are named `path`, `path-1`, `path-2`, and so
+ *              on, skipping names that are taken. They are cut down to the
+ *              size actually used when moving on and on
+ *              `ezc_log_segment_close`. After a crash, the unused tail of the
+ *              last file reads as zeroes. Opening another segment closes
+ *              the current one.
+ *  @param      path        Name of the first file.
+ *  @param      size        Size of each file. Longer messages are skipped.
+ *  @returns    `0` on success, or `-1` if the file could not be mapped.
+ */
+int ezc_log_segment_open(char const *path, long size);
+
+
+
+/** @brief      Stop copying logs into memory-mapped files.
+ *  @details    Waits for threads that are still copying, then trims and
+ *              closes the current file.
+ */
+void ezc_log_segment_close();
+
+
+
+/** @brief      Echo logs from a background thread.
+ *  @details    From now on `ezc_log` only queues the formatted message for
+ *              echoing, and a writer thread performs the actual file I/O.
+ *              Messages are still added to the global log right away.
+ *              Pending messages are written when the program exits. Calling
+ *              this while already asynchronous only changes `full`.
+ *  @param      capacity    Maximum number of messages waiting to be echoed.
+ *  @param      full        What to do when the queue is full. See
+ *                          `ezc_log_full_t`.
+ */
+void ezc_log_async_start(long capacity, ezc_log_full_t full);
+
+
+
+/** @brief      Go back to echoing logs synchronously.
+ *  @details    Waits for the writer thread to echo all pending messages.
+ */
+void ezc_log_async_stop();
+
+
+
+/** @brief      Wait until all logged messages have been echoed.
+ *  @details    Also flushes the echo destination and the log file, and
+ *              logs the summaries of messages dropped by `ezc_log_rate`
+ *              that are still due. Returns right away when logging
+ *              synchronously.
+ *              `EZC_LOG_FATAL` messages flush automatically before aborting.
+ */
+void ezc_log_flush();
+
+
+
+/** @brief      Set how much the global log may hold on to.
+ *  @details    Every logging thread keeps its messages in a ring buffer.
+ *              Once it holds `records` messages, or once its messages take
+ *              up more than `bytes`, the thread's oldest messages are
+ *              discarded to make room. By default each thread holds up to
+ *              4096 messages regardless of their size. Shrinking the log
+ *              discards the oldest messages that no longer fit.
+ *  @param      records     Maximum number of messages. Pass `0` or less for
+ *                          the default.
+ *  @param      bytes       Maximum number of bytes taken up by messages.
+ *                          Pass `0` for no byte limit.
+ */
+void ezc_log_capacity(long records, long bytes);
+
+
+
+/** @brief      Set the allocator of log records.
+ *  @details    Each message is kept in a record of its own until it is
+ *              discarded. By default records of short messages come from a
+ *              pool of the log's own, see `ezc_mem_pool`, and the rest from
+ *              the global allocator, see `ezc_mem_allocator`. Records
+ *              remember the allocator they came from, so switching is safe
+ *              at any time, but the allocator must stay alive for as long as
+ *              any of its records might. Its functions must be thread-safe.
+ *  @param      allocator   Allocator of all records. `NULL` for the
+ *                          default.
+ */
+void ezc_log_allocator(ezc_allocator const *allocator);
+
+
+
 /** @brief      Get most recent message of at least given severity.
  *  @details    For example, if the most recent item in the log is of type
  *              `EZC_LOG_WARN`, but `ezc_log_get(EZC_LOG_ERROR)` is called, it
- *              will skip over the warning item and keep stepping back through
- *              the log until an `EZC_LOG_ERROR` item is found.
+ *              will skip over the warning item and return the most recent
+ *              `EZC_LOG_ERROR` or `EZC_LOG_FATAL` item. The latest item of
+ *              each severity is indexed, so this takes constant time no
+ *              matter how many messages the log holds.
  *  @param      type        The returned log will be at least as severe as
  *                          the log type specified by this argument.
  *  @return     The most recent message in the global log. Returns `NULL` if
  *              there have been no messages since the beginning of the program
  *              or the most recent `ezc_log_clear()`, or if no message of at
- *              least `type` priority was found.
+ *              least `type` priority was found. The message is a copy that
+ *              stays valid until the calling thread calls `ezc_log_get`
+ *              again.
  */
 char const* ezc_log_get(ezc_log_t type);
 
 
 
+/** @brief      Iterate over the messages in the global log that match.
+ *  @details    Messages are visited newest first, see
+ *              `ezc_log_query_next`. Only messages logged before the query
+ *              was created are visited. Threads keep logging while it
+ *              exists, the querying thread included, and messages they
+ *              discard before the query gets to them are skipped. Each step
+ *              locks a single thread's log just long enough to copy one
+ *              message, and only messages of matching types are looked at.
+ *  @param      min         Least severe type to match.
+ *  @param      max         Most severe type to match.
+ *  @param      file        Source file to match, or `NULL` for any.
+ *  @param      since       Earliest time to match, or `0`.
+ *  @param      until       Latest time to match, or `0` for no limit.
+ *  @returns    The query, or `NULL` if it could not be allocated.
+ */
+ezc_log_query* ezc_log_query_new(ezc_log_t min, ezc_log_t max,
+                                 char const *file, time_t since, time_t until);
+
+
+
+/** @brief      Step to the next matching message of a query.
+ *  @details    The record and its strings stay valid until the next call on
+ *              the same query or its deletion.
+ *  @param      self        The query.
+ *  @returns    The next matching message, or `NULL` once there are none
+ *              left.
+ */
+ezc_log_record const* ezc_log_query_next(ezc_log_query *self);
+
+
+
+/** @brief      Free given queries.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers.
+ *  @param      self    `ezc_log_query *` Pointer to a query.
+ *  @param      ...     `ezc_log_query *` Optional pointers to additional
+ *                      queries to be freed.
+ *  @returns    N/A
+ */
+#define ezc_log_query_delete(self, ...) \
+    (ezc_log_query_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_log_query_delete__(ezc_log_query *self, ...);
+
+
+
 /** @brief      Write the global log to a file.
  *  @details    The file name is `YYYY-MM-DD-HH-MM-SS.error`, located in the
- *              directory the program was called from. If this file somehow
- *              already exists, it is overwritten. This function <i>does not
- *              </i> clear the log.
+ *              directory the program was called from. If this file already
+ *              exists, `YYYY-MM-DD-HH-MM-SS-N.error` is used instead.
+ *              Messages of all threads are written newest first, in the
+ *              order they were logged. This function <i>does not</i> clear
+ *              the log.
  */
 void ezc_log_fwrite();
 
 
 
+/** @brief      Write the global log as JSON Lines.
+ *  @details    Every message becomes a single line holding an object with
+ *              its `sequence`, `time`, `level`, `file`, `line` and
+ *              `message`. Fields logged by `ezc_log_kv` are added as
+ *              members of their own, so the output can be fed straight to
+ *              log shippers. Messages are written newest first.
+ *  @param      dest        Where to write the log.
+ */
+void ezc_log_fwrite_json(FILE *dest);
+
+
+
+/** @brief      Write the global log to a file in binary form.
+ *  @details    Unlike `ezc_log_fwrite`, messages logged in binary mode are
+ *              not formatted, making this cheap enough to call from a
+ *              program that is about to go down. Read it back with
+ *              `ezc_log_decode`, e.g. via the `decode_log` app, on a machine
+ *              of the same architecture.
+ *  @param      dest        File opened for writing in binary mode.
+ */
+void ezc_log_dump(FILE *dest);
+
+
+
+/** @brief      Format a log written by `ezc_log_dump`.
+ *  @details    Messages are written newest first, exactly as `ezc_log_fwrite`
+ *              would have written them.
+ *  @param      src         File opened for reading in binary mode.
+ *  @param      dest        Where to write the messages.
+ *  @returns    Number of messages decoded, or `-1` if `src` is not a valid
+ *              dump.
+ */
+long ezc_log_decode(FILE *src, FILE *dest);
+
+
+
+/** @brief      Convert a log written by `ezc_log_dump` to JSON Lines.
+ *  @details    Messages are written newest first, exactly as
+ *              `ezc_log_fwrite_json` would have written them.
+ *  @param      src         File opened for reading in binary mode.
+ *  @param      dest        Where to write the messages.
+ *  @returns    Number of messages converted, or `-1` if `src` is not a
+ *              valid dump.
+ */
+long ezc_log_decode_json(FILE *src, FILE *dest);
+
+
+
 /** @brief      Clear the global log.
- *  @details    Clears absolutely everything from info logs to fatal logs.
+ *  @details    Clears and frees absolutely everything from info logs to fatal
+ *              logs.
  */
 void ezc_log_clear();
 
@@ -118,6 +118,19 @@
 
 
 
+/** @brief      Mark a function that may go unused without a warning.
+ *  @details    For `static` functions defined by macros in headers, of which
+ *              most translation units only call a few. Expands to nothing on
+ *              compilers other than GCC and Clang.
+ */
+#if defined(__GNUC__)
+#define EZC_UNUSED __attribute__((unused))
+#else
+#define EZC_UNUSED
+#endif
+
+
+
 #define EZC_TO_ZERO(ptr) ((ptr) = 0)
 
 #define EZC_DO_FREE(ptr) (free((ptr)))
@@ -0,0 +1,333 @@
+/*  ezc_map.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_map.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+#include <string.h>
+
+
+
+/* Smallest table a non-empty map grows to. Must be a power of two. */
+static long const EZC_MAP_MIN_CAPACITY = 8;
+
+
+
+/* The table grows once it would be more than 4/5 full. Robin Hood probing
+ * keeps probe sequences short even at this load. */
+#define EZC_MAP_FITS(length, capacity) ((length) * 5 <= (capacity) * 4)
+
+
+
+static unsigned long ezc_map_hash_of(ezc_map const *self, void const *key)
+{
+    unsigned long const hash =
+        (self->hash != NULL ? (*self->hash)(key) : ezc_map_hash_ptr(key));
+
+    /* 0 marks empty slots */
+    return hash != 0 ? hash : 1;
+}
+
+
+
+/* How far the entry at `i` sits from the slot its hash prefers. */
+static long ezc_map_distance(ezc_map const *self, long i)
+{
+    return (i - (long) (self->slots[i].hash & (self->capacity - 1))) &
+        (self->capacity - 1);
+}
+
+
+
+/* Robin Hood insertion of an entry whose key is known to be absent. Whenever
+ * the probed entry is closer to home than the one being placed, the two swap
+ * and probing continues with the displaced entry. */
+static void ezc_map_place(ezc_map *self, ezc_map_slot entry)
+{
+    long const MASK = self->capacity - 1;
+    long i = (long) (entry.hash & MASK), dist = 0;
+
+    while (self->slots[i].hash != 0)
+    {
+        long const other = ezc_map_distance(self, i);
+
+        if (other < dist)
+        {
+            ezc_map_slot const temp = self->slots[i];
+            self->slots[i] = entry;
+            entry = temp;
+            dist = other;
+        }
+
+        i = (i + 1) & MASK;
+        dist++;
+    }
+
+    self->slots[i] = entry;
+    self->length++;
+}
+
+
+
+ezc_map* ezc_map_new__(unsigned long (*hash)(void const *),
+                       int (*neq)(void const *, void const *))
+{
+    return ezc_map_new_allocator__(NULL, hash, neq);
+}
+
+
+
+ezc_map* ezc_map_new_allocator__(ezc_allocator const *allocator,
+                                 unsigned long (*hash)(void const *),
+                                 int (*neq)(void const *, void const *))
+{
+    ezc_map *self;
+
+    if (allocator == NULL) allocator = EZC_MEM_GLOBAL;
+    self = EZC_MEM_ALLOC(allocator, sizeof *self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate map.");
+        return NULL;
+    }
+
+    self->slots = NULL;
+    self->capacity = 0;
+    self->length = 0;
+    self->hash = hash;
+    self->neq = neq;
+    self->allocator = allocator;
+
+    return self;
+}
+
+
+
+void ezc_map_delete__(ezc_map *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        ezc_allocator const * const ALLOCATOR = self->allocator;
+
+        EZC_MEM_FREE(ALLOCATOR, self->slots);
+        EZC_MEM_FREE(ALLOCATOR, self);
+
+        self = va_arg(arg_ptr, ezc_map*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_map_reserve__(ezc_map *self, long n)
+{
+    assert(self != NULL && n >= 0);
+
+    long capacity = (self->capacity > 0 ? self->capacity :
+            EZC_MAP_MIN_CAPACITY);
+
+    while (!EZC_MAP_FITS(n, capacity)) capacity *= 2;
+
+    if (capacity > self->capacity)
+    {
+        ezc_map_slot *old = self->slots, *slots;
+        long const OLD_CAPACITY = self->capacity;
+        long i;
+
+        slots = EZC_MEM_CALLOC(self->allocator, capacity, sizeof *slots);
+
+        if (slots == NULL)
+        {
+            ezc_log(EZC_LOG_ERROR, "Unable to grow map to %li slots.",
+                    capacity);
+            return;
+        }
+
+        self->slots = slots;
+        self->capacity = capacity;
+        self->length = 0;
+
+        for (i = 0; i < OLD_CAPACITY; i++)
+        {
+            if (old[i].hash != 0) ezc_map_place(self, old[i]);
+        }
+
+        EZC_MEM_FREE(self->allocator, old);
+    }
+}
+
+
+
+void ezc_map_clear__(ezc_map *self)
+{
+    assert(self != NULL);
+
+    if (self->slots != NULL)
+    {
+        memset(self->slots, 0, self->capacity * sizeof *self->slots);
+    }
+
+    self->length = 0;
+}
+
+
+
+long ezc_map_find__(ezc_map const *self, void const *key)
+{
+    assert(self != NULL);
+
+    if (self->length > 0)
+    {
+        long const MASK = self->capacity - 1;
+        unsigned long const HASH = ezc_map_hash_of(self, key);
+        long i = (long) (HASH & MASK), dist = 0;
+
+        /* An entry closer to home than our probe distance means the key
+         * would have been placed before it, so it cannot be further on. */
+        while (self->slots[i].hash != 0 && ezc_map_distance(self, i) >= dist)
+        {
+            if (self->slots[i].hash == HASH &&
+                    (self->neq != NULL ?
+                     !(*self->neq)(self->slots[i].key, key) :
+                     self->slots[i].key == key))
+            {
+                return i;
+            }
+
+            i = (i + 1) & MASK;
+            dist++;
+        }
+    }
+
+    return -1;
+}
+
+
+
+int ezc_map_set__(ezc_map *self, void const *key, void const *value)
+{
+    long const i = ezc_map_find__(self, key);
+    ezc_map_slot entry;
+
+    if (i >= 0)
+    {
+        self->slots[i].value = (void *) value;
+        return 0;
+    }
+
+    if (!EZC_MAP_FITS(self->length + 1, self->capacity))
+    {
+        ezc_map_reserve__(self, self->length + 1);
+        if (!EZC_MAP_FITS(self->length + 1, self->capacity)) return -1;
+    }
+
+    entry.key = (void *) key;
+    entry.value = (void *) value;
+    entry.hash = ezc_map_hash_of(self, key);
+
+    ezc_map_place(self, entry);
+    return 0;
+}
+
+
+
+void* ezc_map_get__(ezc_map const *self, void const *key)
+{
+    long const i = ezc_map_find__(self, key);
+    return i >= 0 ? self->slots[i].value : NULL;
+}
+
+
+
+void* ezc_map_pop__(ezc_map *self, void const *key)
+{
+    long i = ezc_map_find__(self, key);
+    void *popped = NULL;
+
+    if (i >= 0)
+    {
+        long const MASK = self->capacity - 1;
+        long next = (i + 1) & MASK;
+
+        popped = self->slots[i].value;
+
+        /* Backward shift deletion: pull following entries one slot closer
+         * to home until one is already home or a slot is empty. This leaves
+         * no tombstones behind. */
+        while (self->slots[next].hash != 0 &&
+                ezc_map_distance(self, next) > 0)
+        {
+            self->slots[i] = self->slots[next];
+            i = next;
+            next = (next + 1) & MASK;
+        }
+
+        self->slots[i].hash = 0;
+        self->slots[i].key = NULL;
+        self->slots[i].value = NULL;
+        self->length--;
+    }
+
+    return popped;
+}
+
+
+
+unsigned long ezc_map_hash_str(void const *key)
+{
+    /* FNV-1a */
+    unsigned char const *iter = key;
+    unsigned long hash = 2166136261UL;
+
+    while (*iter != '\0')
+    {
+        hash ^= *iter++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+
+
+unsigned long ezc_map_hash_ptr(void const *key)
+{
+    /* Pointers tend to have zeroed low bits due to alignment, and the table
+     * only looks at the low bits, so mix the high bits down */
+    unsigned long hash = (unsigned long) key;
+
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bUL;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bUL;
+    hash ^= hash >> 16;
+
+    return hash;
+}
@@ -0,0 +1,286 @@
+/*  ezc_map.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_MAP_H
+#define EZC_MAP_H
+
+/** @file       ezc_map.h
+ *  @brief      Hash map implementation.
+ *  @details    Maps `void *` keys to `void *` values. Entries live in one
+ *              contiguous table using open addressing with Robin Hood linear
+ *              probing, so insertion, lookup and erasure are `O(1)` on
+ *              average. Use this instead of `ezc_list_get_match_fn` whenever
+ *              you are really looking things up by key.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <stddef.h>
+
+
+
+/** @brief      Hash map slot structure.
+ *  @details    A slot whose `hash` is `0` is empty.
+ */
+typedef struct ezc_map_slot
+{
+    /** Entry's key. */
+    void *key;
+
+    /** Entry's value. */
+    void *value;
+
+    /** Cached hash of `key`, never `0` for an occupied slot. */
+    unsigned long hash;
+}
+ezc_map_slot;
+
+
+
+/** @brief      Hash map structure.
+ *  @details    Feel free to read the members directly, but only modify them
+ *              via the functions below.
+ */
+typedef struct ezc_map
+{
+    /** Table of `capacity` slots. */
+    ezc_map_slot *slots;
+
+    /** Number of slots in the table. Always `0` or a power of two. */
+    long capacity;
+
+    /** Number of entries in the map. */
+    long length;
+
+    /** Hash function for keys. */
+    unsigned long (*hash)(void const *);
+
+    /** Key comparison function. Returns `0` if the keys are equal. */
+    int (*neq)(void const *, void const *);
+
+    /** Allocator of the map and `slots`. `NULL` for the standard library. */
+    ezc_allocator const *allocator;
+}
+ezc_map;
+
+
+
+/** @brief      Initialize a blank map.
+ *  @param      hash    Pointer to a function. This function should accept a
+ *                      `void const *` key and return its `unsigned long` hash.
+ *                      Pass `NULL` to hash the pointers themselves.
+ *  @param      neq     Pointer to a function. This function should accept two
+ *                      `void const *` keys. It should <i>return</i> `0` <i>if
+ *                      the two are equal</i>, anything else otherwise, just
+ *                      like `strcmp`. Pass `NULL` to compare via `!=`.
+ *  @returns    `ezc_map *` Pointer to allocated map, or `NULL`.
+ */
+#define ezc_map_new(hash, neq) \
+    (ezc_map_new__((hash), (neq)))
+
+ezc_map* ezc_map_new__(unsigned long (*hash)(void const *),
+                       int (*neq)(void const *, void const *));
+
+
+
+/** @brief      Initialize a blank map that uses the given allocator.
+ *  @details    Works just like `ezc_map_new`, but the map and its table are
+ *              allocated via `allocator` rather than the global allocator,
+ *              see `ezc_mem_allocator`.
+ *  @param      allocator   `ezc_allocator const *` Allocator, which must
+ *                          outlive the map. `NULL` for the global one.
+ *  @param      hash        See `ezc_map_new`.
+ *  @param      neq         See `ezc_map_new`.
+ *  @returns    `ezc_map *` Pointer to allocated map, or `NULL`.
+ */
+#define ezc_map_new_allocator(allocator, hash, neq) \
+    (ezc_map_new_allocator__((allocator), (hash), (neq)))
+
+ezc_map* ezc_map_new_allocator__(ezc_allocator const *allocator,
+                                 unsigned long (*hash)(void const *),
+                                 int (*neq)(void const *, void const *));
+
+
+
+/** @brief      Free given maps.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers. The keys and values themselves are not freed.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      ...     `ezc_map *` Optional pointers to additional maps to be
+ *                      freed.
+ *  @returns    N/A
+ */
+#define ezc_map_delete(self, ...) \
+    (ezc_map_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_map_delete__(ezc_map *self, ...);
+
+
+
+/** @brief      Number of entries in map.
+ *  @param      self    `ezc_map const *` Pointer to a map.
+ *  @returns    `long` Number of entries.
+ */
+#define ezc_map_length(self) \
+    ((self)->length)
+
+
+
+/** @brief      Make room for at least `n` entries.
+ *  @details    Avoids rehashing while the map grows up to `n` entries.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      n       `long` Number of entries.
+ *  @returns    N/A
+ */
+#define ezc_map_reserve(self, n) \
+    (ezc_map_reserve__((self), (n)))
+
+void ezc_map_reserve__(ezc_map *self, long n);
+
+
+
+/** @brief      Remove all entries.
+ *  @details    The table itself is kept for reuse.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @returns    N/A
+ */
+#define ezc_map_clear(self) \
+    (ezc_map_clear__((self)))
+
+void ezc_map_clear__(ezc_map *self);
+
+
+
+/** @brief      Insert or overwrite an entry.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      key     `void const *` Key of the entry.
+ *  @param      value   `void const *` Value of the entry.
+ *  @returns    `int` `0` on success, or `-1` if the map could not grow, in
+ *              which case it is left as it was.
+ */
+#define ezc_map_set(self, key, value) \
+    (ezc_map_set__((self), (key), (value)))
+
+int ezc_map_set__(ezc_map *self, void const *key, void const *value);
+
+
+
+/** @brief      Get value stored under key.
+ *  @param      self    `ezc_map const *` Pointer to a map.
+ *  @param      key     `void const *` Key of the entry.
+ *  @returns    `void *` The value stored under `key`, or `NULL` if there was
+ *              none. Use `ezc_map_has` if `NULL` values are meaningful.
+ */
+#define ezc_map_get(self, key) \
+    (ezc_map_get__((self), (key)))
+
+void* ezc_map_get__(ezc_map const *self, void const *key);
+
+
+
+/** @brief      Check whether an entry exists.
+ *  @param      self    `ezc_map const *` Pointer to a map.
+ *  @param      key     `void const *` Key of the entry.
+ *  @returns    `int` Nonzero if an entry is stored under `key`.
+ */
+#define ezc_map_has(self, key) \
+    (ezc_map_find__((self), (key)) >= 0)
+
+long ezc_map_find__(ezc_map const *self, void const *key);
+
+
+
+/** @brief      Pop entry.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      key     `void const *` Key of the entry.
+ *  @returns    `void *` The value that was stored under `key`, or `NULL` if
+ *              there was none.
+ */
+#define ezc_map_pop(self, key) \
+    (ezc_map_pop__((self), (key)))
+
+void* ezc_map_pop__(ezc_map *self, void const *key);
+
+
+
+/** @brief      Erase entry.
+ *  @details    The key and value themselves are not freed.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      key     `void const *` Key of the entry.
+ *  @returns    N/A
+ */
+#define ezc_map_erase(self, key) \
+    ((void) ezc_map_pop__((self), (key)))
+
+
+
+/** @brief      Apply function to each entry of map.
+ *  @details    Entries are visited in table order, which is unspecified. Do
+ *              not insert into or erase from the map while mapping.
+ *  @param      self    `ezc_map *` Pointer to a map.
+ *  @param      fn      Pointer to a function. The first two arguments of the
+ *                      function must accept the entry's key and value. The
+ *                      arguments that it accepts thereafter should match what
+ *                      you provide in the `...`.
+ *  @param      ...     The arguments to be passed to `fn` following the key
+ *                      and value.
+ *  @returns    N/A
+ */
+#define ezc_map_map(self, fn, ...) \
+    do { ezc_map *iter = (self); long iter_i; \
+        for (iter_i = 0; iter_i < iter->capacity; iter_i++) \
+            if (iter->slots[iter_i].hash != 0) \
+                (fn)(iter->slots[iter_i].key, iter->slots[iter_i].value, \
+                     ##__VA_ARGS__); \
+    } while(0)
+
+
+
+/** @brief      Hash a `NUL` terminated string.
+ *  @details    Pass this to `ezc_map_new` along with `strcmp` for maps keyed
+ *              by strings.
+ *  @param      key     `char const *` String to hash.
+ *  @returns    `unsigned long` Hash of the string.
+ */
+unsigned long ezc_map_hash_str(void const *key);
+
+
+
+/** @brief      Hash a pointer.
+ *  @details    This is what `ezc_map_new` uses when no hash is provided.
+ *  @param      key     `void const *` Pointer to hash.
+ *  @returns    `unsigned long` Hash of the pointer.
+ */
+unsigned long ezc_map_hash_ptr(void const *key);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_MAP_H */
@@ -0,0 +1,987 @@
+/*  ezc_mem.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_mem.h"
+
+#include "ezc/ezc_atomic.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef EZC_MEM_TRACK
+#include <limits.h>
+#include <stdio.h>
+#endif
+
+
+
+/* Whether the memory was passed to `EZC_MEM_KEEP`. */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_KEPT(ptr) 0
+#else
+#define EZC_MEM_KEPT(ptr) (ezc_mem_track_kept__((ptr)))
+#endif
+
+
+
+/* Bytes per slab of a pool, unless its objects are so large that fewer than
+ * `EZC_MEM_POOL_MIN_OBJECTS` would fit. */
+#define EZC_MEM_POOL_SLAB_SIZE 16384
+#define EZC_MEM_POOL_MIN_OBJECTS 8
+
+/* Free objects move between a thread's cache and the pool's shared list this
+ * many at a time. A cache holds at most twice as many. */
+#define EZC_MEM_POOL_BATCH 32
+
+
+
+/* Anything `malloc` would align */
+typedef union ezc_mem_align
+{
+    long double align_float;
+    void *align_pointer;
+    long align_integer;
+}
+ezc_mem_align;
+
+
+
+typedef struct ezc_mem_pool_object
+{
+    struct ezc_mem_pool_object *next;
+}
+ezc_mem_pool_object;
+
+
+
+typedef union ezc_mem_pool_slab
+{
+    union ezc_mem_pool_slab *next;
+    ezc_mem_align align;
+}
+ezc_mem_pool_slab;
+
+
+
+/* Free objects of one thread for one pool. Each thread lists its caches,
+ * most recently used first, and each pool lists the caches drawing from it.
+ * Caches belong to their thread, which frees them as it exits. */
+typedef struct ezc_mem_pool_cache
+{
+    /* `NULL` once the pool is deleted. Only ever touched atomically. */
+    ezc_mem_pool *pool;
+
+    ezc_mem_pool_object *head;
+    long count;
+
+    /* Caches of the same pool, guarded by `EZC_MEM_POOL_LOCK` */
+    struct ezc_mem_pool_cache *prev, *next;
+
+    /* Caches of the same thread */
+    struct ezc_mem_pool_cache *thread_next;
+}
+ezc_mem_pool_cache;
+
+
+
+struct ezc_mem_pool
+{
+    /* Size of each object, rounded up to keep every object aligned */
+    size_t size;
+    long per_slab;
+
+    /* Global allocator at the time the pool was made, which the pool keeps
+     * using even if the global allocator changes later on */
+    ezc_allocator const *allocator;
+
+    /* Guards the three members below */
+    pthread_mutex_t lock;
+    ezc_mem_pool_object *shared;
+    ezc_mem_pool_slab *slabs;
+
+    ezc_mem_pool_cache *caches;
+};
+
+
+
+/* One thread-specific key for all pools, since the number of keys is
+ * limited. It holds the most recently used cache of the calling thread. */
+static pthread_key_t EZC_MEM_POOL_KEY;
+static pthread_once_t EZC_MEM_POOL_ONCE = PTHREAD_ONCE_INIT;
+
+/* Guards which caches belong to which pool */
+static pthread_mutex_t EZC_MEM_POOL_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+ezc_allocator const *ezc_mem_allocator__ = NULL;
+
+
+
+void ezc_mem_allocator(ezc_allocator const *allocator)
+{
+    ezc_mem_allocator__ = allocator;
+}
+
+
+
+void* ezc_mem_calloc__(ezc_allocator const *a, size_t n, size_t size)
+{
+    void *ptr;
+
+    /* Same overflow check as `calloc` */
+    if (size != 0 && n > (size_t) -1 / size) return NULL;
+
+    ptr = EZC_MEM_ALLOC__(a, n * size);
+    if (ptr != NULL) memset(ptr, 0, n * size);
+
+    return ptr;
+}
+
+
+
+/* Move up to `n` objects from the shared list to the front of `*head`. Call
+ * with the pool locked. Returns the number moved. */
+static long ezc_mem_pool_take(ezc_mem_pool *self, ezc_mem_pool_object **head,
+                              long n)
+{
+    long moved = 0;
+
+    if (self->shared == NULL)
+    {
+        /* Carve a new slab, threading its objects onto the shared list */
+        ezc_mem_pool_slab *slab = EZC_MEM_ALLOC(self->allocator,
+                sizeof *slab + self->size * self->per_slab);
+        char *iter;
+        long i;
+
+        if (slab == NULL) return 0;
+        if (EZC_MEM_KEPT(self)) EZC_MEM_KEEP(slab);
+
+        slab->next = self->slabs;
+        self->slabs = slab;
+
+        iter = (char *) (slab + 1) + self->size * self->per_slab;
+
+        for (i = 0; i < self->per_slab; i++)
+        {
+            ezc_mem_pool_object *object;
+
+            iter -= self->size;
+            object = (ezc_mem_pool_object *) iter;
+            object->next = self->shared;
+            self->shared = object;
+        }
+    }
+
+    while (moved < n && self->shared != NULL)
+    {
+        ezc_mem_pool_object * const object = self->shared;
+
+        self->shared = object->next;
+        object->next = *head;
+        *head = object;
+        moved++;
+    }
+
+    return moved;
+}
+
+
+
+/* Move up to `n` objects from the front of `*head` to the shared list. Call
+ * with the pool locked. */
+static void ezc_mem_pool_give(ezc_mem_pool *self, ezc_mem_pool_object **head,
+                              long n)
+{
+    while (n-- > 0 && *head != NULL)
+    {
+        ezc_mem_pool_object * const object = *head;
+
+        *head = object->next;
+        object->next = self->shared;
+        self->shared = object;
+    }
+}
+
+
+
+/* Called with the most recently used cache of every thread that exits */
+static void ezc_mem_pool_thread_release(void *cache)
+{
+    ezc_mem_pool_cache *iter;
+
+    pthread_mutex_lock(&EZC_MEM_POOL_LOCK);
+
+    for (iter = cache; iter != NULL; iter = iter->thread_next)
+    {
+        ezc_mem_pool * const pool = EZC_ATOMIC_LOAD(&iter->pool);
+
+        if (pool != NULL)
+        {
+            pthread_mutex_lock(&pool->lock);
+            ezc_mem_pool_give(pool, &iter->head, iter->count);
+            pthread_mutex_unlock(&pool->lock);
+
+            if (iter->prev != NULL) iter->prev->next = iter->next;
+            else pool->caches = iter->next;
+            if (iter->next != NULL) iter->next->prev = iter->prev;
+        }
+    }
+
+    pthread_mutex_unlock(&EZC_MEM_POOL_LOCK);
+
+    while (cache != NULL)
+    {
+        ezc_mem_pool_cache *next = ((ezc_mem_pool_cache *) cache)->thread_next;
+        EZC_FREE(cache);
+        cache = next;
+    }
+}
+
+
+
+static void ezc_mem_pool_key_create()
+{
+    pthread_key_create(&EZC_MEM_POOL_KEY, ezc_mem_pool_thread_release);
+}
+
+
+
+/* The calling thread's cache, which is created on first use. */
+static ezc_mem_pool_cache* ezc_mem_pool_cache_get(ezc_mem_pool *self)
+{
+    ezc_mem_pool_cache * const head = pthread_getspecific(EZC_MEM_POOL_KEY);
+    ezc_mem_pool_cache *cache, **iter;
+
+    /* Threads tend to use one pool at a time */
+    if (head != NULL && EZC_ATOMIC_LOAD(&head->pool) == self) return head;
+
+    iter = (head != NULL ? &head->thread_next : NULL);
+
+    while (iter != NULL && (cache = *iter) != NULL)
+    {
+        ezc_mem_pool * const pool = EZC_ATOMIC_LOAD(&cache->pool);
+
+        if (pool == self)
+        {
+            /* Move to the front */
+            *iter = cache->thread_next;
+            cache->thread_next = head;
+            pthread_setspecific(EZC_MEM_POOL_KEY, cache);
+            return cache;
+        }
+        else if (pool == NULL)
+        {
+            /* Its pool is gone, so nobody else knows about it anymore */
+            *iter = cache->thread_next;
+            EZC_FREE(cache);
+        }
+        else
+        {
+            iter = &cache->thread_next;
+        }
+    }
+
+    EZC_NEW(cache);
+    if (cache == NULL) return NULL;
+    if (EZC_MEM_KEPT(self)) EZC_MEM_KEEP(cache);
+
+    cache->pool = self;
+    cache->head = NULL;
+    cache->count = 0;
+    cache->prev = NULL;
+    cache->thread_next = head;
+
+    pthread_mutex_lock(&EZC_MEM_POOL_LOCK);
+    cache->next = self->caches;
+    if (cache->next != NULL) cache->next->prev = cache;
+    self->caches = cache;
+    pthread_mutex_unlock(&EZC_MEM_POOL_LOCK);
+
+    pthread_setspecific(EZC_MEM_POOL_KEY, cache);
+    return cache;
+}
+
+
+
+/* Free the calling thread's caches whose pool is gone. */
+static void ezc_mem_pool_thread_prune()
+{
+    ezc_mem_pool_cache *head = pthread_getspecific(EZC_MEM_POOL_KEY);
+    ezc_mem_pool_cache **iter = &head, *cache;
+
+    while ((cache = *iter) != NULL)
+    {
+        if (EZC_ATOMIC_LOAD(&cache->pool) == NULL)
+        {
+            *iter = cache->thread_next;
+            EZC_FREE(cache);
+        }
+        else
+        {
+            iter = &cache->thread_next;
+        }
+    }
+
+    pthread_setspecific(EZC_MEM_POOL_KEY, head);
+}
+
+
+
+ezc_mem_pool* ezc_mem_pool_new(size_t size)
+{
+    size_t const ALIGN = sizeof(ezc_mem_align);
+    ezc_allocator const * const ALLOCATOR = EZC_MEM_GLOBAL;
+    ezc_mem_pool *self;
+
+    pthread_once(&EZC_MEM_POOL_ONCE, ezc_mem_pool_key_create);
+
+    self = EZC_MEM_ALLOC(ALLOCATOR, sizeof *self);
+    if (self == NULL) return NULL;
+
+    if (size < sizeof(ezc_mem_pool_object))
+    {
+        size = sizeof(ezc_mem_pool_object);
+    }
+
+    self->size = (size + ALIGN - 1) / ALIGN * ALIGN;
+    self->per_slab = EZC_MEM_POOL_SLAB_SIZE / self->size;
+
+    if (self->per_slab < EZC_MEM_POOL_MIN_OBJECTS)
+    {
+        self->per_slab = EZC_MEM_POOL_MIN_OBJECTS;
+    }
+
+    self->allocator = ALLOCATOR;
+    pthread_mutex_init(&self->lock, NULL);
+    self->shared = NULL;
+    self->slabs = NULL;
+    self->caches = NULL;
+
+    return self;
+}
+
+
+
+void ezc_mem_pool_delete__(ezc_mem_pool *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    int deleted = 0;
+
+    while (self != NULL)
+    {
+        ezc_allocator const * const ALLOCATOR = self->allocator;
+        ezc_mem_pool_cache *cache, *next;
+
+        /* Disown the caches, which their threads free later on. A thread
+         * may free its cache as soon as it sees that, hence reading `next`
+         * first. */
+        pthread_mutex_lock(&EZC_MEM_POOL_LOCK);
+
+        for (cache = self->caches; cache != NULL; cache = next)
+        {
+            next = cache->next;
+            EZC_ATOMIC_STORE(&cache->pool, (ezc_mem_pool *) NULL);
+        }
+
+        pthread_mutex_unlock(&EZC_MEM_POOL_LOCK);
+
+        while (self->slabs != NULL)
+        {
+            ezc_mem_pool_slab *slab = self->slabs;
+            self->slabs = slab->next;
+            EZC_MEM_FREE(ALLOCATOR, slab);
+        }
+
+        pthread_mutex_destroy(&self->lock);
+        EZC_MEM_FREE(ALLOCATOR, self);
+        deleted = 1;
+
+        self = va_arg(arg_ptr, ezc_mem_pool*);
+    }
+
+    /* Other threads get to their caches the next time they use any pool */
+    if (deleted) ezc_mem_pool_thread_prune();
+
+    va_end(arg_ptr);
+}
+
+
+
+void* ezc_mem_pool_alloc(ezc_mem_pool *self)
+{
+    ezc_mem_pool_cache * const cache = ezc_mem_pool_cache_get(self);
+    ezc_mem_pool_object *object = NULL;
+
+    if (cache == NULL)
+    {
+        /* Without a cache, go straight to the shared list */
+        pthread_mutex_lock(&self->lock);
+        ezc_mem_pool_take(self, &object, 1);
+        pthread_mutex_unlock(&self->lock);
+
+        return object;
+    }
+
+    if (cache->head == NULL)
+    {
+        pthread_mutex_lock(&self->lock);
+        cache->count += ezc_mem_pool_take(self, &cache->head,
+                EZC_MEM_POOL_BATCH);
+        pthread_mutex_unlock(&self->lock);
+
+        if (cache->head == NULL) return NULL;
+    }
+
+    object = cache->head;
+    cache->head = object->next;
+    cache->count--;
+
+    return object;
+}
+
+
+
+void ezc_mem_pool_free(ezc_mem_pool *self, void *ptr)
+{
+    ezc_mem_pool_cache *cache;
+    ezc_mem_pool_object *object = ptr;
+
+    if (object == NULL) return;
+
+    cache = ezc_mem_pool_cache_get(self);
+
+    if (cache == NULL)
+    {
+        object->next = NULL;
+
+        pthread_mutex_lock(&self->lock);
+        ezc_mem_pool_give(self, &object, 1);
+        pthread_mutex_unlock(&self->lock);
+
+        return;
+    }
+
+    object->next = cache->head;
+    cache->head = object;
+
+    /* Keep a thread that mostly frees from hoarding objects. The most
+     * recently freed ones are the likeliest to still be cached by the CPU,
+     * so those stay. */
+    if (++cache->count >= 2 * EZC_MEM_POOL_BATCH)
+    {
+        ezc_mem_pool_object *keep = cache->head, *rest;
+        long i;
+
+        for (i = 1; i < EZC_MEM_POOL_BATCH; i++) keep = keep->next;
+
+        rest = keep->next;
+        keep->next = NULL;
+
+        pthread_mutex_lock(&self->lock);
+        ezc_mem_pool_give(self, &rest, cache->count - EZC_MEM_POOL_BATCH);
+        pthread_mutex_unlock(&self->lock);
+
+        cache->count = EZC_MEM_POOL_BATCH;
+    }
+}
+
+
+
+long ezc_mem_pool_free_chain(ezc_mem_pool *self, void *head, size_t offset)
+{
+    ezc_mem_pool_object *last = NULL;
+    char *iter = head;
+    long count = 0;
+
+    /* Relink the objects through their first bytes, reading each pointer to
+     * the next object before it may get overwritten */
+    while (iter != NULL)
+    {
+        char * const next = *(void **) (iter + offset);
+
+        last = (ezc_mem_pool_object *) iter;
+        last->next = (ezc_mem_pool_object *) next;
+        iter = next;
+        count++;
+    }
+
+    if (last != NULL)
+    {
+        pthread_mutex_lock(&self->lock);
+        last->next = self->shared;
+        self->shared = head;
+        pthread_mutex_unlock(&self->lock);
+    }
+
+    return count;
+}
+
+
+
+#ifdef EZC_MEM_TRACK
+
+/* Most distinct call sites and modules that are told apart. Allocations
+ * beyond that are attributed to the first entry of each table. */
+#define EZC_MEM_SITES 1024
+#define EZC_MEM_MODULES 128
+
+/* Size of the index of call sites. Must be a power of two. */
+#define EZC_MEM_INDEX (2 * EZC_MEM_SITES)
+
+
+
+/* Only ever touched atomically, so that any thread may allocate, free and
+ * read statistics at the same time. */
+typedef struct ezc_mem_counter
+{
+    long allocs, frees;
+    long live, peak;
+}
+ezc_mem_counter;
+
+
+
+/* Source file without directory and extension. */
+typedef struct ezc_mem_module
+{
+    char const *name;
+    long length;
+    ezc_mem_counter counter;
+}
+ezc_mem_module;
+
+
+
+typedef struct ezc_mem_site
+{
+    char const *file;
+    long line;
+    long module;
+    ezc_mem_counter counter;
+
+    /* Allocations passed to `EZC_MEM_KEEP` that are still around, and
+     * their bytes */
+    long kept, kept_size;
+}
+ezc_mem_site;
+
+
+
+/* Precedes every tracked allocation. The union keeps what follows it aligned
+ * as well as `malloc` would. */
+typedef union ezc_mem_header
+{
+    struct
+    {
+        long site;
+        long size;
+
+        /* Whether it was passed to `EZC_MEM_KEEP` */
+        long kept;
+    }
+    info;
+
+    ezc_mem_align align;
+}
+ezc_mem_header;
+
+
+
+static ezc_mem_counter EZC_MEM_TOTAL;
+
+static ezc_mem_module EZC_MEM_MODULE[EZC_MEM_MODULES] = { { "?", 1 } };
+static long EZC_MEM_MODULE_COUNT = 1;
+
+static ezc_mem_site EZC_MEM_SITE[EZC_MEM_SITES] = { { "?", 0, 0 } };
+static long EZC_MEM_SITE_COUNT = 1;
+
+/* Open addressing index of sites by file and line. Holds index + 1 of each
+ * site and 0 in empty slots. Only ever grows, so lookups need no lock. */
+static long EZC_MEM_SITE_INDEX[EZC_MEM_INDEX];
+static pthread_mutex_t EZC_MEM_SITE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+static void ezc_mem_count_alloc(ezc_mem_counter *counter, long size)
+{
+    long const LIVE = EZC_ATOMIC_ADD(&counter->live, size) + size;
+    long peak = EZC_ATOMIC_LOAD(&counter->peak);
+
+    EZC_ATOMIC_ADD(&counter->allocs, 1);
+
+    while (LIVE > peak && !EZC_ATOMIC_CAS(&counter->peak, peak, LIVE))
+    {
+        peak = EZC_ATOMIC_LOAD(&counter->peak);
+    }
+}
+
+
+
+static void ezc_mem_count_free(ezc_mem_counter *counter, long size)
+{
+    EZC_ATOMIC_ADD(&counter->live, -size);
+    EZC_ATOMIC_ADD(&counter->frees, 1);
+}
+
+
+
+static void ezc_mem_counter_read(ezc_mem_counter *counter,
+                                 ezc_mem_stats *stats)
+{
+    stats->allocs = EZC_ATOMIC_LOAD(&counter->allocs);
+    stats->frees = EZC_ATOMIC_LOAD(&counter->frees);
+    stats->live = EZC_ATOMIC_LOAD(&counter->live);
+    stats->peak = EZC_ATOMIC_LOAD(&counter->peak);
+}
+
+
+
+static void ezc_mem_report_at_exit()
+{
+    ezc_mem_leaks(stderr);
+}
+
+
+
+/* Index of the module of the given file. Call with the site lock held. */
+static long ezc_mem_module_of(char const *file)
+{
+    char const *name = file, *iter;
+    long length, i;
+
+    for (iter = file; *iter != '\0'; iter++)
+    {
+        if (*iter == '/' || *iter == '\\') name = iter + 1;
+    }
+
+    iter = strrchr(name, '.');
+    length = (iter != NULL ? iter - name : (long) strlen(name));
+
+    for (i = 1; i < EZC_MEM_MODULE_COUNT; i++)
+    {
+        if (EZC_MEM_MODULE[i].length == length &&
+                strncmp(EZC_MEM_MODULE[i].name, name, length) == 0)
+        {
+            return i;
+        }
+    }
+
+    if (i == EZC_MEM_MODULES) return 0;
+
+    EZC_MEM_MODULE[i].name = name;
+    EZC_MEM_MODULE[i].length = length;
+    EZC_ATOMIC_STORE(&EZC_MEM_MODULE_COUNT, i + 1);
+
+    return i;
+}
+
+
+
+/* Index of the site of the given call. The file name is told apart by address
+ * rather than by contents, which is what keeps lookups cheap. */
+static long ezc_mem_site_of(char const *file, long line)
+{
+    unsigned long const HASH =
+        ((unsigned long) file >> 3) * 31UL + (unsigned long) line;
+    long i = (long) (HASH & (EZC_MEM_INDEX - 1)), n;
+
+    /* Fast path, whenever the site allocated before */
+    while ((n = EZC_ATOMIC_LOAD(&EZC_MEM_SITE_INDEX[i])) != 0)
+    {
+        if (EZC_MEM_SITE[n - 1].file == file &&
+                EZC_MEM_SITE[n - 1].line == line) return n - 1;
+
+        i = (i + 1) & (EZC_MEM_INDEX - 1);
+    }
+
+    pthread_mutex_lock(&EZC_MEM_SITE_LOCK);
+
+    /* Someone else may have added it in the meantime */
+    while ((n = EZC_MEM_SITE_INDEX[i]) != 0 &&
+            (EZC_MEM_SITE[n - 1].file != file ||
+             EZC_MEM_SITE[n - 1].line != line))
+    {
+        i = (i + 1) & (EZC_MEM_INDEX - 1);
+    }
+
+    if (n == 0)
+    {
+        n = EZC_MEM_SITE_COUNT;
+
+        if (n == 1) atexit(ezc_mem_report_at_exit);
+
+        if (n < EZC_MEM_SITES)
+        {
+            EZC_MEM_SITE[n].file = file;
+            EZC_MEM_SITE[n].line = line;
+            EZC_MEM_SITE[n].module = ezc_mem_module_of(file);
+            EZC_ATOMIC_STORE(&EZC_MEM_SITE_COUNT, n + 1);
+            EZC_ATOMIC_STORE(&EZC_MEM_SITE_INDEX[i], n + 1);
+        }
+        else
+        {
+            /* Full, so lump it in with the other leftovers */
+            n = 0;
+        }
+    }
+    else
+    {
+        n--;
+    }
+
+    pthread_mutex_unlock(&EZC_MEM_SITE_LOCK);
+    return n;
+}
+
+
+
+static void* ezc_mem_track(ezc_mem_header *header, long size,
+                           char const *file, long line)
+{
+    long const SITE = ezc_mem_site_of(file, line);
+    ezc_mem_site * const site = &EZC_MEM_SITE[SITE];
+
+    header->info.site = SITE;
+    header->info.size = size;
+    header->info.kept = 0;
+
+    ezc_mem_count_alloc(&site->counter, size);
+    ezc_mem_count_alloc(&EZC_MEM_MODULE[site->module].counter, size);
+    ezc_mem_count_alloc(&EZC_MEM_TOTAL, size);
+
+    return header + 1;
+}
+
+
+
+static void ezc_mem_untrack(ezc_mem_header const *header)
+{
+    ezc_mem_site * const site = &EZC_MEM_SITE[header->info.site];
+    long const SIZE = header->info.size;
+
+    if (header->info.kept)
+    {
+        EZC_ATOMIC_ADD(&site->kept, -1);
+        EZC_ATOMIC_ADD(&site->kept_size, -SIZE);
+    }
+
+    ezc_mem_count_free(&site->counter, SIZE);
+    ezc_mem_count_free(&EZC_MEM_MODULE[site->module].counter, SIZE);
+    ezc_mem_count_free(&EZC_MEM_TOTAL, SIZE);
+}
+
+
+
+void* ezc_mem_track_alloc__(ezc_allocator const *a, size_t size,
+                            char const *file, long line)
+{
+    ezc_mem_header *header = NULL;
+
+    if (size <= LONG_MAX - sizeof *header)
+    {
+        header = EZC_MEM_ALLOC__(a, sizeof *header + size);
+    }
+
+    return header == NULL ? NULL : ezc_mem_track(header, size, file, line);
+}
+
+
+
+void* ezc_mem_track_calloc__(ezc_allocator const *a, size_t n, size_t size,
+                             char const *file, long line)
+{
+    void *ptr;
+
+    if (size != 0 && n > (size_t) -1 / size) return NULL;
+
+    ptr = ezc_mem_track_alloc__(a, n * size, file, line);
+    if (ptr != NULL) memset(ptr, 0, n * size);
+
+    return ptr;
+}
+
+
+
+void* ezc_mem_track_realloc__(ezc_allocator const *a, void *ptr, size_t size,
+                              char const *file, long line)
+{
+    ezc_mem_header *header, old;
+
+    if (ptr == NULL) return ezc_mem_track_alloc__(a, size, file, line);
+    if (size > LONG_MAX - sizeof *header) return NULL;
+
+    /* Resizing may move the header along with everything else */
+    header = (ezc_mem_header *) ptr - 1;
+    old = *header;
+    header = EZC_MEM_REALLOC__(a, header, sizeof *header + size);
+    if (header == NULL) return NULL;
+
+    ezc_mem_untrack(&old);
+    ptr = ezc_mem_track(header, size, file, line);
+    if (old.info.kept) ezc_mem_track_keep__(ptr);
+
+    return ptr;
+}
+
+
+
+void ezc_mem_track_free__(ezc_allocator const *a, void *ptr)
+{
+    if (ptr != NULL)
+    {
+        ezc_mem_header * const header = (ezc_mem_header *) ptr - 1;
+
+        ezc_mem_untrack(header);
+        EZC_MEM_FREE__(a, header);
+    }
+}
+
+
+
+void ezc_mem_track_keep__(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        ezc_mem_header * const header = (ezc_mem_header *) ptr - 1;
+
+        ezc_mem_site * const site = &EZC_MEM_SITE[header->info.site];
+
+        if (!header->info.kept)
+        {
+            header->info.kept = 1;
+            EZC_ATOMIC_ADD(&site->kept, 1);
+            EZC_ATOMIC_ADD(&site->kept_size, header->info.size);
+        }
+    }
+}
+
+
+
+int ezc_mem_track_kept__(void const *ptr)
+{
+    return ptr != NULL && ((ezc_mem_header const *) ptr - 1)->info.kept;
+}
+
+
+
+int ezc_mem_stats_get(char const *module, ezc_mem_stats *stats)
+{
+    long const COUNT = EZC_ATOMIC_LOAD(&EZC_MEM_MODULE_COUNT);
+    long i;
+
+    if (module == NULL)
+    {
+        ezc_mem_counter_read(&EZC_MEM_TOTAL, stats);
+        return 0;
+    }
+
+    for (i = 1; i < COUNT; i++)
+    {
+        if (EZC_MEM_MODULE[i].length == (long) strlen(module) &&
+                strncmp(EZC_MEM_MODULE[i].name, module,
+                    EZC_MEM_MODULE[i].length) == 0)
+        {
+            ezc_mem_counter_read(&EZC_MEM_MODULE[i].counter, stats);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+
+
+void ezc_mem_dump(FILE *dest)
+{
+    long const MODULES = EZC_ATOMIC_LOAD(&EZC_MEM_MODULE_COUNT);
+    long const SITES = EZC_ATOMIC_LOAD(&EZC_MEM_SITE_COUNT);
+    ezc_mem_stats stats;
+    char site[64];
+    long i, j;
+
+    ezc_mem_counter_read(&EZC_MEM_TOTAL, &stats);
+
+    fprintf(dest, "%-40s %10s %10s %10s %10s\n", "MODULE / SITE", "LIVE",
+            "PEAK", "ALLOCS", "FREES");
+    fprintf(dest, "%-40s %10li %10li %10li %10li\n", "(total)", stats.live,
+            stats.peak, stats.allocs, stats.frees);
+
+    for (i = 0; i < MODULES; i++)
+    {
+        ezc_mem_counter_read(&EZC_MEM_MODULE[i].counter, &stats);
+        if (stats.allocs == 0) continue;
+
+        fprintf(dest, "%-40.*s %10li %10li %10li %10li\n",
+                (int) EZC_MEM_MODULE[i].length, EZC_MEM_MODULE[i].name,
+                stats.live, stats.peak, stats.allocs, stats.frees);
+
+        for (j = 0; j < SITES; j++)
+        {
+            if (EZC_MEM_SITE[j].module != i) continue;
+
+            ezc_mem_counter_read(&EZC_MEM_SITE[j].counter, &stats);
+            if (stats.allocs == 0) continue;
+
+            sprintf(site, "%.40s:%li", EZC_MEM_SITE[j].file,
+                    EZC_MEM_SITE[j].line);
+            fprintf(dest, "  %-38s %10li %10li %10li %10li\n", site,
+                    stats.live, stats.peak, stats.allocs, stats.frees);
+        }
+    }
+}
+
+
+
+long ezc_mem_leaks(FILE *dest)
+{
+    long const SITES = EZC_ATOMIC_LOAD(&EZC_MEM_SITE_COUNT);
+    ezc_mem_stats stats;
+    long left = 0, i;
+
+    for (i = 0; i < SITES; i++)
+    {
+        ezc_mem_site * const site = &EZC_MEM_SITE[i];
+        long count;
+
+        ezc_mem_counter_read(&site->counter, &stats);
+        count = stats.allocs - stats.frees - EZC_ATOMIC_LOAD(&site->kept);
+        if (count <= 0) continue;
+
+        if (dest != NULL)
+        {
+            if (left == 0) fprintf(dest, "Allocations left:\n");
+
+            fprintf(dest, "%s:%li: %li allocations, %li bytes\n", site->file,
+                    site->line, count,
+                    stats.live - EZC_ATOMIC_LOAD(&site->kept_size));
+        }
+
+        left += count;
+    }
+
+    return left;
+}
+
+#endif /* EZC_MEM_TRACK */
@@ -25,6 +25,12 @@
 /** @file       ezc_mem.h
  *  @brief      Memory-related macros, such as allocation and array length
  *              getters.
+ *  @details    All allocations of the library go through these macros, and
+ *              thereby through `malloc`, `realloc` and `free` unless another
+ *              allocator is plugged in, see `ezc_allocator`. Define
+ *              `EZC_MEM_TRACK` when compiling the library and everything that
+ *              includes it to also keep statistics of every allocation, see
+ *              `ezc_mem_dump`.
  */
 
 #ifdef __cplusplus
@@ -34,8 +40,316 @@ extern C
 
 #include "ezc/ezc_macro.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 
+#ifdef EZC_MEM_TRACK
+#include <stdio.h>
+#endif
+
+
+
+/** @brief      Allocator interface.
+ *  @details    Plug one in globally via `ezc_mem_allocator`, or for a single
+ *              container or the log via the respective `_allocator`
+ *              functions. Its functions must behave like their standard
+ *              library counterparts and must not log.
+ */
+typedef struct ezc_allocator
+{
+    /** Counterpart of `malloc`. */
+    void* (*alloc)(void *context, size_t size);
+
+    /** Counterpart of `realloc`. */
+    void* (*realloc)(void *context, void *ptr, size_t size);
+
+    /** Counterpart of `free`. Passed `NULL` never. */
+    void (*free)(void *context, void *ptr);
+
+    /** Passed to the functions above, e.g. a pool or arena. */
+    void *context;
+}
+ezc_allocator;
+
+
+
+/** @brief      Allocator used whenever no other is specified.
+ *  @details    `NULL` stands for the standard library, which is the default.
+ *              Read only. Define `EZC_MEM_LIBC` before including `ezc_mem.h`,
+ *              or on the command line, to compile every allocation straight
+ *              to the standard library.
+ */
+#ifdef EZC_MEM_LIBC
+#define EZC_MEM_GLOBAL ((ezc_allocator const *) NULL)
+#else
+#define EZC_MEM_GLOBAL (ezc_mem_allocator__)
+#endif
+
+extern ezc_allocator const *ezc_mem_allocator__;
+
+
+
+/** @brief      Set the allocator used whenever no other is specified.
+ *  @details    Everything has to be freed by the allocator that allocated it,
+ *              so set this before the library allocates anything, e.g. at
+ *              startup, and while no other thread is running. Has no effect
+ *              if `EZC_MEM_LIBC` is defined.
+ *  @param      allocator   The allocator, which must stay alive for as long
+ *                          as it is in use. `NULL` for the standard library.
+ */
+void ezc_mem_allocator(ezc_allocator const *allocator);
+
+
+
+/** @brief      Allocate memory via the given allocator.
+ *  @param      a       `ezc_allocator const *` Allocator, `NULL` for the
+ *                      standard library. May be evaluated more than once.
+ *  @param      size    `size_t` Number of bytes.
+ *  @returns    `void *` Pointer to the memory, or `NULL`.
+ */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_ALLOC(a, size) EZC_MEM_ALLOC__(a, size)
+#else
+#define EZC_MEM_ALLOC(a, size) \
+    (ezc_mem_track_alloc__((a), (size), __FILE__, __LINE__))
+#endif
+
+#define EZC_MEM_ALLOC__(a, size) \
+    ((a) == NULL ? malloc(size) : (*(a)->alloc)((a)->context, (size)))
+
+
+
+/** @brief      Allocate a zero-initialized array via the given allocator.
+ *  @param      a       `ezc_allocator const *` Allocator, `NULL` for the
+ *                      standard library. May be evaluated more than once.
+ *  @param      n       `size_t` Number of elements.
+ *  @param      size    `size_t` Size of each element in bytes.
+ *  @returns    `void *` Pointer to the memory, or `NULL`.
+ */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_CALLOC(a, n, size) \
+    ((a) == NULL ? calloc((n), (size)) : ezc_mem_calloc__((a), (n), (size)))
+#else
+#define EZC_MEM_CALLOC(a, n, size) \
+    (ezc_mem_track_calloc__((a), (n), (size), __FILE__, __LINE__))
+#endif
+
+void* ezc_mem_calloc__(ezc_allocator const *a, size_t n, size_t size);
+
+
+
+/** @brief      Resize memory via the allocator that allocated it.
+ *  @param      a       `ezc_allocator const *` Allocator, `NULL` for the
+ *                      standard library. May be evaluated more than once.
+ *  @param      ptr     `void *` Memory to resize, or `NULL`.
+ *  @param      size    `size_t` New number of bytes.
+ *  @returns    `void *` Pointer to the memory, or `NULL` if it could not be
+ *              resized, in which case `ptr` is left alone.
+ */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_REALLOC(a, ptr, size) EZC_MEM_REALLOC__(a, ptr, size)
+#else
+#define EZC_MEM_REALLOC(a, ptr, size) \
+    (ezc_mem_track_realloc__((a), (ptr), (size), __FILE__, __LINE__))
+#endif
+
+#define EZC_MEM_REALLOC__(a, ptr, size) \
+    ((a) == NULL ? realloc((ptr), (size)) : \
+     (*(a)->realloc)((a)->context, (ptr), (size)))
+
+
+
+/** @brief      Free memory via the allocator that allocated it.
+ *  @param      a       `ezc_allocator const *` Allocator, `NULL` for the
+ *                      standard library. May be evaluated more than once.
+ *  @param      ptr     `void *` Memory to free, or `NULL`.
+ */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_FREE(a, ptr) EZC_MEM_FREE__(a, ptr)
+#else
+#define EZC_MEM_FREE(a, ptr) (ezc_mem_track_free__((a), (ptr)))
+#endif
+
+#define EZC_MEM_FREE__(a, ptr) \
+    ((a) == NULL ? free(ptr) : \
+     (ptr) != NULL ? (*(a)->free)((a)->context, (ptr)) : (void) 0)
+
+
+
+/** @brief      Leave memory out of leak reports, see `ezc_mem_leaks`.
+ *  @details    Meant for memory that lasts as long as the program, such as
+ *              the library's own log and pools. The slabs and caches of a
+ *              kept pool are left out as well. Does nothing unless
+ *              `EZC_MEM_TRACK` is defined.
+ *  @param      ptr     `void *` Memory allocated via the macros above, or
+ *                      `NULL`.
+ */
+#ifndef EZC_MEM_TRACK
+#define EZC_MEM_KEEP(ptr) ((void) (ptr))
+#else
+#define EZC_MEM_KEEP(ptr) (ezc_mem_track_keep__((ptr)))
+#endif
+
+
+
+/** @brief      Pool of fixed-size objects.
+ *  @details    Suits objects of one type that come and go at a high rate.
+ *              Objects are carved out of large slabs, so they end up packed
+ *              together, and each thread keeps a cache of free objects, so
+ *              most allocations and frees are a handful of instructions
+ *              without any locking. Objects may be freed by any thread.
+ *              All pools share a single thread-specific key, so there is no
+ *              limit on how many pools may exist at once.
+ *              Opaque, see the functions below.
+ */
+typedef struct ezc_mem_pool ezc_mem_pool;
+
+
+
+/** @brief      Initialize a pool of objects of the given size.
+ *  @details    Slabs are allocated via the global allocator at the time of
+ *              this call, see `ezc_mem_allocator`, which the pool sticks to
+ *              even if the global allocator changes later on. Slabs are only
+ *              freed along with the pool.
+ *  @param      size    `size_t` Size of each object in bytes.
+ *  @returns    `ezc_mem_pool *` Pointer to allocated pool, or `NULL`.
+ */
+ezc_mem_pool* ezc_mem_pool_new(size_t size);
+
+
+
+/** @brief      Free given pools.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers. Every object of a pool goes with it, and no thread
+ *              may use the pool anymore.
+ *  @param      self    `ezc_mem_pool *` Pointer to a pool.
+ *  @param      ...     `ezc_mem_pool *` Optional pointers to additional pools
+ *                      to be freed.
+ *  @returns    N/A
+ */
+#define ezc_mem_pool_delete(self, ...) \
+    (ezc_mem_pool_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_mem_pool_delete__(ezc_mem_pool *self, ...);
+
+
+
+/** @brief      Allocate an object from a pool.
+ *  @param      self    `ezc_mem_pool *` Pointer to a pool.
+ *  @returns    `void *` Pointer to the object, which is aligned as well as
+ *              `malloc` would align it, or `NULL`.
+ */
+void* ezc_mem_pool_alloc(ezc_mem_pool *self);
+
+
+
+/** @brief      Return an object to the pool it came from.
+ *  @param      self    `ezc_mem_pool *` Pointer to the pool.
+ *  @param      ptr     `void *` The object, or `NULL`.
+ *  @returns    N/A
+ */
+void ezc_mem_pool_free(ezc_mem_pool *self, void *ptr);
+
+
+
+/** @brief      Return a whole chain of objects to the pool they came from.
+ *  @details    Each object points to the next one through a pointer `offset`
+ *              bytes into it, and the last one points to `NULL`. The chain
+ *              is handed back under a single lock rather than object by
+ *              object.
+ *  @param      self    `ezc_mem_pool *` Pointer to the pool.
+ *  @param      head    `void *` The first object, or `NULL`.
+ *  @param      offset  `size_t` Where the pointer to the next object is, as
+ *                      given by `offsetof`.
+ *  @returns    `long` Number of objects returned.
+ */
+long ezc_mem_pool_free_chain(ezc_mem_pool *self, void *head, size_t offset);
+
+
+
+/** @brief      Allocation statistics.
+ *  @details    Reallocations count as a free followed by an allocation.
+ */
+typedef struct ezc_mem_stats
+{
+    /** Number of allocations. */
+    long allocs;
+
+    /** Number of frees. */
+    long frees;
+
+    /** Bytes currently allocated. */
+    long live;
+
+    /** Most bytes ever allocated at once. */
+    long peak;
+}
+ezc_mem_stats;
+
+
+
+/** @brief      Get the allocation statistics of a module.
+ *  @details    Allocations are attributed to the source file they were made
+ *              from. Its name without directory and extension is the module,
+ *              e.g. `ezc_log` for everything `ezc/ezc_log.c` allocates.
+ *  @param      module  `char const *` Name of the module, or `NULL` for all
+ *                      allocations together.
+ *  @param      stats   `ezc_mem_stats *` Filled in with the statistics.
+ *  @returns    `int` 0 on success, or -1 if the module never allocated
+ *              anything or `EZC_MEM_TRACK` is not defined, in which case
+ *              `stats` is left alone.
+ */
+#ifdef EZC_MEM_TRACK
+int ezc_mem_stats_get(char const *module, ezc_mem_stats *stats);
+#else
+#define ezc_mem_stats_get(module, stats) ((void) (module), (void) (stats), -1)
+#endif
+
+
+
+/** @brief      Write the allocation statistics of every module and every
+ *              call site to a file.
+ *  @details    Does nothing unless `EZC_MEM_TRACK` is defined.
+ *  @param      dest    `FILE *` File to write to, e.g. `stdout`.
+ */
+#ifdef EZC_MEM_TRACK
+void ezc_mem_dump(FILE *dest);
+#else
+#define ezc_mem_dump(dest) ((void) (dest))
+#endif
+
+
+
+/** @brief      Report allocations that have not been freed yet.
+ *  @details    Lists the call sites of such allocations along with how many
+ *              of them are left and their size in bytes. A report is written
+ *              to `stderr` at exit if anything is left by then. Does nothing
+ *              unless `EZC_MEM_TRACK` is defined.
+ *              Memory passed to `EZC_MEM_KEEP` is left out.
+ *  @param      dest    `FILE *` File to write to, or `NULL` to only count.
+ *  @returns    `long` Number of allocations left.
+ */
+#ifdef EZC_MEM_TRACK
+long ezc_mem_leaks(FILE *dest);
+#else
+#define ezc_mem_leaks(dest) ((void) (dest), 0L)
+#endif
+
+
+
+#ifdef EZC_MEM_TRACK
+void* ezc_mem_track_alloc__(ezc_allocator const *a, size_t size,
+                            char const *file, long line);
+void* ezc_mem_track_calloc__(ezc_allocator const *a, size_t n, size_t size,
+                             char const *file, long line);
+void* ezc_mem_track_realloc__(ezc_allocator const *a, void *ptr, size_t size,
+                              char const *file, long line);
+void ezc_mem_track_free__(ezc_allocator const *a, void *ptr);
+void ezc_mem_track_keep__(void *ptr);
+int ezc_mem_track_kept__(void const *ptr);
+#endif
+
 
 
 /** @brief      Get the length of an array.
@@ -51,7 +365,7 @@ extern C
  *              `ptr = ...` for you, all you need to do is `EZC_NEW(ptr);`.
  *  @param      ptr     Pointer to which you want memory allocated.
  */
-#define EZC_NEW(ptr) ((ptr) = malloc(sizeof *(ptr)))
+#define EZC_NEW(ptr) ((ptr) = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, sizeof *(ptr)))
 
 
 
@@ -60,7 +374,8 @@ extern C
  *  @details    `EZC_NEW` details documentation also applies to `EZC_NEW0`.
  *  @param      ptr     Pointer to which you want memory allocated.
  */
-#define EZC_NEW0(ptr) ((ptr) = calloc(1, sizeof *(ptr)))
+#define EZC_NEW0(ptr) \
+    ((ptr) = EZC_MEM_CALLOC(EZC_MEM_GLOBAL, 1, sizeof *(ptr)))
 
 
 
@@ -68,7 +383,8 @@ extern C
  *  @details    `EZC_NEW` details documentation also applies to `EZC_NEWN`.
  *  @param      ptr     Pointer to which you want memory allocated.
  */
-#define EZC_NEWN(ptr, n) ((ptr) = calloc((n), sizeof *(ptr)))
+#define EZC_NEWN(ptr, n) \
+    ((ptr) = EZC_MEM_CALLOC(EZC_MEM_GLOBAL, (n), sizeof *(ptr)))
 
 
 
@@ -80,8 +396,10 @@ extern C
  *  @param      ...     Optional additional pointers you want to be freed.
  */
 #define EZC_FREE(ptr, ...) \
-    (SST_MAP(EZC_DO_FREE, ptr, ##__VA_ARGS__), \
-     SST_MAP(EZC_TO_ZERO, ptr, ##__VA_ARGS__))
+    (SST_MAP_LIST(EZC_MEM_DO_FREE, ptr, ##__VA_ARGS__), \
+     SST_MAP_LIST(EZC_TO_ZERO, ptr, ##__VA_ARGS__))
+
+#define EZC_MEM_DO_FREE(ptr) EZC_MEM_FREE(EZC_MEM_GLOBAL, (ptr))
 
 
 
@@ -0,0 +1,402 @@
+/*  ezc_timer.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_timer.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_map.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+
+
+
+/* Every level of the wheel has `1 << EZC_TIMER_BITS` slots, each covering
+ * as many ticks as the whole level below. Five levels reach 2^30 ticks ahead,
+ * which still fits a 32 bit `long`. Timers further out than that simply
+ * cascade down more than once. */
+#define EZC_TIMER_BITS 6
+#define EZC_TIMER_SLOTS (1L << EZC_TIMER_BITS)
+#define EZC_TIMER_MASK (EZC_TIMER_SLOTS - 1)
+#define EZC_TIMER_LEVELS 5
+
+/* Slot of level `level` that covers time `t` */
+#define EZC_TIMER_INDEX(t, level) \
+    (((t) >> ((level) * EZC_TIMER_BITS)) & EZC_TIMER_MASK)
+
+
+
+/* Circular doubly linked list. Each slot has an empty one as its head. */
+typedef struct ezc_timer_link
+{
+    struct ezc_timer_link *prev, *next;
+}
+ezc_timer_link;
+
+
+
+typedef struct ezc_timer_entry
+{
+    /* Must come first, so that links of entries cast to entries */
+    ezc_timer_link link;
+
+    long deadline, period;
+    ezc_callback const *callback;
+
+    /* Level of the wheel it was last placed on */
+    int level;
+
+    /* `0` once cancelled */
+    ezc_timer_handle handle;
+}
+ezc_timer_entry;
+
+
+
+struct ezc_timer
+{
+    ezc_timer_link wheel[EZC_TIMER_LEVELS][EZC_TIMER_SLOTS];
+
+    /* Next tick to process. Everything before it has expired already. */
+    long next;
+
+    /* Number of timers scheduled, and how many of them are on each level.
+     * Entries about to expire still count towards level 0. */
+    long length;
+    long counts[EZC_TIMER_LEVELS];
+
+    /* Handle to `ezc_timer_entry *` */
+    ezc_map *entries;
+    ezc_timer_handle last;
+};
+
+
+
+static void ezc_timer_link_init(ezc_timer_link *head)
+{
+    head->prev = head->next = head;
+}
+
+
+
+static void ezc_timer_link_add(ezc_timer_link *head, ezc_timer_link *link)
+{
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+
+
+static void ezc_timer_link_remove(ezc_timer_link *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    ezc_timer_link_init(link);
+}
+
+
+
+/* Move all links of `from` over to `to`, leaving `from` empty */
+static void ezc_timer_link_move(ezc_timer_link *from, ezc_timer_link *to)
+{
+    ezc_timer_link_init(to);
+
+    if (from->next != from)
+    {
+        to->next = from->next;
+        to->prev = from->prev;
+        to->next->prev = to;
+        to->prev->next = to;
+        ezc_timer_link_init(from);
+    }
+}
+
+
+
+/* Put an entry into the slot that covers its deadline, on the lowest level
+ * that reaches that far */
+static void ezc_timer_place(ezc_timer *self, ezc_timer_entry *entry)
+{
+    long const AHEAD = entry->deadline - self->next;
+    long deadline = entry->deadline;
+    int level = 0;
+
+    if (AHEAD < 0)
+    {
+        /* Overdue, so expire on the next tick */
+        deadline = self->next;
+    }
+    else
+    {
+        while (level < EZC_TIMER_LEVELS - 1 &&
+                AHEAD >= 1L << ((level + 1) * EZC_TIMER_BITS))
+        {
+            level++;
+        }
+
+        /* Beyond the top level. Lands as far out as possible for now. */
+        if (level == EZC_TIMER_LEVELS - 1 &&
+                AHEAD >> (EZC_TIMER_LEVELS * EZC_TIMER_BITS) != 0)
+        {
+            deadline = self->next +
+                (1L << (EZC_TIMER_LEVELS * EZC_TIMER_BITS)) - 1;
+        }
+    }
+
+    ezc_timer_link_add(&self->wheel[level][EZC_TIMER_INDEX(deadline, level)],
+            &entry->link);
+    entry->level = level;
+    self->counts[level]++;
+}
+
+
+
+static void ezc_timer_unlink(ezc_timer *self, ezc_timer_entry *entry)
+{
+    ezc_timer_link_remove(&entry->link);
+    self->counts[entry->level]--;
+}
+
+
+
+/* Spread the entries of a slot of `level` over the levels below it. Returns
+ * the index of the slot, which is `0` once the level has come full circle. */
+static long ezc_timer_cascade(ezc_timer *self, int level)
+{
+    long const INDEX = EZC_TIMER_INDEX(self->next, level);
+    ezc_timer_link pending;
+
+    ezc_timer_link_move(&self->wheel[level][INDEX], &pending);
+
+    while (pending.next != &pending)
+    {
+        ezc_timer_entry * const entry = (ezc_timer_entry *) pending.next;
+
+        ezc_timer_unlink(self, entry);
+        ezc_timer_place(self, entry);
+    }
+
+    return INDEX;
+}
+
+
+
+static void ezc_timer_free(ezc_timer *self, ezc_timer_entry *entry)
+{
+    if (entry->handle != 0) ezc_map_erase(self->entries, (void *) entry->handle);
+    EZC_FREE(entry);
+    self->length--;
+}
+
+
+
+ezc_timer* ezc_timer_new(long now)
+{
+    ezc_timer *self;
+    int level;
+    long i;
+
+    EZC_NEW(self);
+
+    if (self == NULL || (self->entries = ezc_map_new(NULL, NULL)) == NULL)
+    {
+        EZC_FREE(self);
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate timer.");
+        return NULL;
+    }
+
+    for (level = 0; level < EZC_TIMER_LEVELS; level++)
+    {
+        for (i = 0; i < EZC_TIMER_SLOTS; i++)
+        {
+            ezc_timer_link_init(&self->wheel[level][i]);
+        }
+    }
+
+    for (level = 0; level < EZC_TIMER_LEVELS; level++)
+    {
+        self->counts[level] = 0;
+    }
+
+    self->next = now + 1;
+    self->length = 0;
+    self->last = 0;
+
+    return self;
+}
+
+
+
+void ezc_timer_delete__(ezc_timer *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        int level;
+        long i;
+
+        for (level = 0; level < EZC_TIMER_LEVELS; level++)
+        {
+            for (i = 0; i < EZC_TIMER_SLOTS; i++)
+            {
+                ezc_timer_link * const head = &self->wheel[level][i];
+
+                while (head->next != head)
+                {
+                    ezc_timer_link *link = head->next;
+
+                    ezc_timer_link_remove(link);
+                    EZC_FREE(link);
+                }
+            }
+        }
+
+        ezc_map_delete(self->entries);
+        EZC_FREE(self);
+
+        self = va_arg(arg_ptr, ezc_timer*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+ezc_timer_handle ezc_timer_schedule(ezc_timer *self, long deadline,
+                                    long period,
+                                    ezc_callback const *callback)
+{
+    assert(self != NULL && period >= 0);
+
+    ezc_timer_entry *entry;
+    EZC_NEW(entry);
+
+    if (entry == NULL ||
+            ezc_map_set(self->entries, (void *) (self->last + 1), entry) != 0)
+    {
+        EZC_FREE(entry);
+        ezc_log(EZC_LOG_ERROR, "Unable to schedule timer for tick %li.",
+                deadline);
+        return 0;
+    }
+
+    entry->deadline = deadline;
+    entry->period = period;
+    entry->callback = callback;
+    entry->handle = ++self->last;
+
+    ezc_timer_link_init(&entry->link);
+    ezc_timer_place(self, entry);
+    self->length++;
+
+    return entry->handle;
+}
+
+
+
+int ezc_timer_cancel(ezc_timer *self, ezc_timer_handle handle)
+{
+    assert(self != NULL);
+
+    ezc_timer_entry * const entry = (handle != 0 ?
+            ezc_map_pop(self->entries, (void *) handle) : NULL);
+
+    if (entry == NULL) return -1;
+
+    entry->handle = 0;
+
+    /* An entry that is expiring right now is off the wheel, and is freed by
+     * `ezc_timer_tick` once its callback returns */
+    if (entry->link.next != &entry->link)
+    {
+        ezc_timer_unlink(self, entry);
+        ezc_timer_free(self, entry);
+    }
+
+    return 0;
+}
+
+
+
+long ezc_timer_tick(ezc_timer *self, long now)
+{
+    assert(self != NULL);
+
+    long performed = 0;
+
+    while (self->next <= now)
+    {
+        ezc_timer_link expired;
+        int level;
+
+        /* While the lowest levels are empty, nothing can expire before the
+         * level above them comes round to cascade, so skip right there */
+        for (level = 0; level < EZC_TIMER_LEVELS - 1 &&
+                self->counts[level] == 0; level++)
+        {
+            long const SPAN = 1L << ((level + 1) * EZC_TIMER_BITS);
+            long const ROUND = (self->next + SPAN - 1) & ~(SPAN - 1);
+
+            self->next = (ROUND <= now ? ROUND : now + 1);
+        }
+
+        if (self->next > now) break;
+
+        /* Whenever a level comes full circle, the next slot of the level
+         * above is due to be spread over it */
+        for (level = 1; level < EZC_TIMER_LEVELS &&
+                EZC_TIMER_INDEX(self->next, level - 1) == 0; level++)
+        {
+            if (ezc_timer_cascade(self, level) != 0) break;
+        }
+
+        ezc_timer_link_move(&self->wheel[0][EZC_TIMER_INDEX(self->next, 0)],
+                &expired);
+        self->next++;
+
+        /* Callbacks may schedule and cancel, even entries still in
+         * `expired`. New ones land at `self->next` or later. */
+        while (expired.next != &expired)
+        {
+            ezc_timer_entry * const entry = (ezc_timer_entry *) expired.next;
+
+            ezc_timer_unlink(self, entry);
+            ezc_callback_call(entry->callback);
+            performed++;
+
+            if (entry->handle != 0 && entry->period > 0)
+            {
+                entry->deadline += entry->period;
+                ezc_timer_place(self, entry);
+            }
+            else
+            {
+                ezc_timer_free(self, entry);
+            }
+        }
+    }
+
+    return performed;
+}
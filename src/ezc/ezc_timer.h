@@ -0,0 +1,136 @@
+/*  ezc_timer.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_TIMER_H
+#define EZC_TIMER_H
+
+/** @file       ezc_timer.h
+ *  @brief      Timers that perform callbacks at a deadline, once or
+ *              periodically.
+ *  @details    Timers are kept in a hierarchical timing wheel, so scheduling
+ *              and cancelling take `O(1)` time no matter how many timers
+ *              there are, and `ezc_timer_tick` only ever looks at timers
+ *              that are about to expire. Time is measured in ticks of
+ *              whatever unit suits the caller, e.g. milliseconds. Meant to
+ *              be driven by a single event loop thread, so there is no
+ *              locking.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_callback.h"
+#include "ezc/ezc_macro.h"
+
+
+
+/** @brief      Timer wheel object.
+ *  @details    This is an opaque `struct`. Please use the provided interface
+ *              to interact with it.
+ */
+typedef struct ezc_timer ezc_timer;
+
+
+
+/** @brief      Identifies a scheduled timer, see `ezc_timer_schedule`.
+ *  @details    Never `0` for a valid timer. Handles are not reused, so
+ *              cancelling a timer that has already fired is harmless.
+ */
+typedef long ezc_timer_handle;
+
+
+
+/** @brief      Create a new timer wheel without any timers.
+ *  @param      now     Current time, in ticks.
+ *  @returns    Pointer to newly allocated timer wheel.
+ */
+ezc_timer* ezc_timer_new(long now);
+
+
+
+/** @brief      Free given timer wheels.
+ *  @details    Also set the pointers to equal `NULL` to help prevent dangling
+ *              pointers. Pending timers are dropped without being performed.
+ *              The callback objects themselves are not freed.
+ *  @param      self    `ezc_timer *` Pointer to a timer wheel.
+ *  @param      ...     `ezc_timer *` Optional pointers to additional timer
+ *                      wheels to be freed.
+ *  @returns    N/A
+ */
+#define ezc_timer_delete(self, ...) \
+    (ezc_timer_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_timer_delete__(ezc_timer *self, ...);
+
+
+
+/** @brief      Perform a callback once a deadline has passed.
+ *  @details    Deadlines that have already passed expire on the next tick.
+ *              May be called from within a timer's callback.
+ *  @param      self        Pointer to a timer wheel.
+ *  @param      deadline    When to perform the callback, in ticks.
+ *  @param      period      Perform the callback again every `period` ticks
+ *                          after `deadline`, until cancelled. `0` for once.
+ *  @param      callback    Pointer to a callback object. Not copied, so it
+ *                          must outlive the timer.
+ *  @returns    Handle for `ezc_timer_cancel`, or `0` if the timer could not
+ *              be allocated.
+ */
+ezc_timer_handle ezc_timer_schedule(ezc_timer *self, long deadline,
+                                    long period,
+                                    ezc_callback const *callback);
+
+
+
+/** @brief      Cancel a timer before it expires (again).
+ *  @details    May be called from within a timer's callback, including its
+ *              own.
+ *  @param      self    Pointer to a timer wheel.
+ *  @param      handle  Handle returned by `ezc_timer_schedule`.
+ *  @returns    `0` on success, or `-1` if the timer has already fired for
+ *              the last time or has been cancelled before.
+ */
+int ezc_timer_cancel(ezc_timer *self, ezc_timer_handle handle);
+
+
+
+/** @brief      Advance time, performing the callbacks of expired timers.
+ *  @details    Timers expire in order of their deadlines, one tick at a
+ *              time. Periodic timers that missed several periods expire once
+ *              for each. Stretches of time without any timers expiring are
+ *              skipped, so advancing far at once is cheap.
+ *  @param      self    Pointer to a timer wheel.
+ *  @param      now     Current time, in ticks. Time never goes backwards, so
+ *                      earlier times do nothing.
+ *  @returns    Number of callbacks performed.
+ */
+long ezc_timer_tick(ezc_timer *self, long now);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_TIMER_H */
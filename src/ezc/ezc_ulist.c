@@ -0,0 +1,376 @@
+/*  ezc_ulist.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_ulist.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+#include <string.h>
+
+
+
+static ezc_ulist* ezc_ulist_block_new()
+{
+    ezc_ulist *block;
+    EZC_NEW(block);
+
+    if (block == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Could not allocate list block.");
+        return NULL;
+    }
+
+    block->next = NULL;
+    block->count = 0;
+
+    return block;
+}
+
+
+
+/* Insert data at `*offset` within `block`. A full block is split in half
+ * when inserting in between its items. At either of its ends, the data goes
+ * into the front of the next block if that has room, or else into a fresh
+ * block, so that pushing to the front or back leaves the other blocks full. Returns the block the data ended up in and moves
+ * `*offset` right past it, so consecutive calls insert consecutive items.
+ * Returns `NULL`, leaving the list as it was, if allocating fails. */
+static ezc_ulist* ezc_ulist_insert(ezc_ulist *block, long *offset, void *data)
+{
+    if (block->count == EZC_ULIST_CAPACITY && *offset == block->count &&
+            block->next != NULL &&
+            block->next->count < EZC_ULIST_CAPACITY)
+    {
+        block = block->next;
+        *offset = 0;
+    }
+    else if (block->count == EZC_ULIST_CAPACITY)
+    {
+        /* Items from `KEEP` on move to the new block */
+        long const KEEP = (*offset == 0 || *offset == block->count ?
+                *offset : EZC_ULIST_CAPACITY / 2);
+        ezc_ulist *split = ezc_ulist_block_new();
+
+        if (split == NULL) return NULL;
+
+        memcpy(split->data, &block->data[KEEP],
+                (EZC_ULIST_CAPACITY - KEEP) * sizeof(void *));
+        split->count = EZC_ULIST_CAPACITY - KEEP;
+        block->count = KEEP;
+
+        split->next = block->next;
+        block->next = split;
+
+        if (*offset > KEEP || KEEP == EZC_ULIST_CAPACITY)
+        {
+            *offset -= KEEP;
+            block = split;
+        }
+    }
+
+    memmove(&block->data[*offset + 1], &block->data[*offset],
+            (block->count - *offset) * sizeof(void *));
+    block->data[*offset] = data;
+    block->count++;
+    (*offset)++;
+
+    return block;
+}
+
+
+
+ezc_ulist* ezc_ulist_new__(void const *data, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, data);
+
+    ezc_ulist *head = NULL, *block = NULL;
+
+    while (data != NULL)
+    {
+        /* Fill blocks completely, appending a new one whenever needed */
+        if (block == NULL || block->count == EZC_ULIST_CAPACITY)
+        {
+            ezc_ulist *next = ezc_ulist_block_new();
+
+            if (next == NULL)
+            {
+                ezc_ulist_delete(head);
+                va_end(arg_ptr);
+                return NULL;
+            }
+
+            if (block == NULL) head = next;
+            else block->next = next;
+
+            block = next;
+        }
+
+        block->data[block->count++] = (void *) data;
+        data = va_arg(arg_ptr, void const *);
+    }
+
+    va_end(arg_ptr);
+    return head;
+}
+
+
+
+ezc_ulist* ezc_ulist_copy__(ezc_ulist const *orig)
+{
+    ezc_ulist *head = NULL;
+    ezc_ulist **iter = &head;
+
+    while (orig != NULL)
+    {
+        *iter = ezc_ulist_block_new();
+
+        if (*iter == NULL)
+        {
+            ezc_ulist_delete(head);
+            return NULL;
+        }
+
+        (*iter)->count = orig->count;
+        memcpy((*iter)->data, orig->data, orig->count * sizeof(void *));
+
+        iter = &(*iter)->next;
+        orig = orig->next;
+    }
+
+    return head;
+}
+
+
+
+ezc_ulist* ezc_ulist_cat__(ezc_ulist *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    ezc_ulist * const head = self;
+    ezc_ulist *prev, *next;
+
+    /* Stop before the last list so that it is never walked needlessly */
+    while (self != NULL && (next = va_arg(arg_ptr, ezc_ulist*)) != NULL)
+    {
+        prev = self;
+
+        while (prev->next != NULL) prev = prev->next;
+        prev->next = next;
+
+        self = next;
+    }
+
+    va_end(arg_ptr);
+    return head;
+}
+
+
+
+void ezc_ulist_delete__(ezc_ulist *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        ezc_ulist *iter = self, *temp;
+
+        while (iter != NULL)
+        {
+            temp = iter->next;
+            EZC_FREE(iter);
+            iter = temp;
+        }
+
+        self = va_arg(arg_ptr, ezc_ulist*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+long ezc_ulist_length__(ezc_ulist const *self)
+{
+    long length = 0;
+
+    while (self != NULL && length >= 0)
+    {
+        length += self->count;
+        self = self->next;
+    }
+
+    return length;
+}
+
+
+
+void* ezc_ulist_get_at__(ezc_ulist const *self, long n)
+{
+    assert(n >= 0 && n < ezc_ulist_length(self));
+
+    /* Skip whole blocks at a time */
+    while (self != NULL && n >= self->count)
+    {
+        n -= self->count;
+        self = self->next;
+    }
+
+    return self == NULL ? NULL : self->data[n];
+}
+
+
+
+long ezc_ulist_get_index_of_fn__(ezc_ulist const *self,
+                                 int (*neq)(void const *, void const *),
+                                 void const *data)
+{
+    long base = 0, i;
+
+    while (self != NULL)
+    {
+        /* Separate loops so the common `!=` case stays branch-light */
+        if (neq == NULL)
+        {
+            for (i = 0; i < self->count; i++)
+            {
+                if (self->data[i] == data) return base + i;
+            }
+        }
+        else
+        {
+            for (i = 0; i < self->count; i++)
+            {
+                if (!(*neq)(self->data[i], data)) return base + i;
+            }
+        }
+
+        base += self->count;
+        self = self->next;
+    }
+
+    return -1;
+}
+
+
+
+void* ezc_ulist_get_match_fn__(ezc_ulist const *self,
+                               int (*neq)(void const *, void const *),
+                               void const *data)
+{
+    long const n = ezc_ulist_get_index_of_fn__(self, neq, data);
+    return n < 0 ? NULL : ezc_ulist_get_at__(self, n);
+}
+
+
+
+void ezc_ulist_push_at__(ezc_ulist **self, long n, ...)
+{
+    /* Pushing at list length is valid. This is equivalent to push_back. */
+    assert(self != NULL && n >= 0 && n <= ezc_ulist_length(*self));
+
+    va_list arg_ptr;
+    va_start(arg_ptr, n);
+
+    void *data = va_arg(arg_ptr, void *);
+
+    if (data != NULL && *self == NULL) *self = ezc_ulist_block_new();
+
+    if (data != NULL && *self != NULL)
+    {
+        ezc_ulist *block = *self;
+
+        /* Find block and offset for index n. Landing at the end of a block
+         * is preferred over the start of the next one. */
+        while (block->next != NULL && n > block->count)
+        {
+            n -= block->count;
+            block = block->next;
+        }
+
+        while (data != NULL &&
+                (block = ezc_ulist_insert(block, &n, data)) != NULL)
+        {
+            data = va_arg(arg_ptr, void *);
+        }
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void* ezc_ulist_pop_at__(ezc_ulist **self, long n)
+{
+    /* Mind the double pointer parameter! */
+    assert(self != NULL && n >= 0 && n < ezc_ulist_length(*self));
+
+    void *popped = NULL;
+    ezc_ulist **iter = self;
+
+    while (*iter != NULL && n >= (*iter)->count)
+    {
+        n -= (*iter)->count;
+        iter = &(*iter)->next;
+    }
+
+    if (*iter != NULL)
+    {
+        ezc_ulist *block = *iter, *next = block->next;
+
+        popped = block->data[n];
+        block->count--;
+        memmove(&block->data[n], &block->data[n + 1],
+                (block->count - n) * sizeof(void *));
+
+        if (block->count == 0)
+        {
+            *iter = next;
+            EZC_FREE(block);
+        }
+        else if (next != NULL && block->count < EZC_ULIST_CAPACITY / 2 &&
+                block->count + next->count <= EZC_ULIST_CAPACITY)
+        {
+            /* Keep blocks dense by absorbing a sparse neighbor */
+            memcpy(&block->data[block->count], next->data,
+                    next->count * sizeof(void *));
+            block->count += next->count;
+            block->next = next->next;
+            EZC_FREE(next);
+        }
+    }
+
+    return popped;
+}
+
+
+
+void* ezc_ulist_pop_match_fn__(ezc_ulist **self,
+                               int (*neq)(void const *, void const *),
+                               void const *data)
+{
+    long const n = ezc_ulist_get_index_of_fn__(*self, neq, data);
+    return n < 0 ? NULL : ezc_ulist_pop_at__(self, n);
+}
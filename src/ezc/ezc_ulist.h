@@ -0,0 +1,383 @@
+/*  ezc_ulist.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_ULIST_H
+#define EZC_ULIST_H
+
+/** @file       ezc_ulist.h
+ *  @brief      Unrolled singly linked list implementation.
+ *  @details    Same idea and interface as `ezc_list`, except that each block
+ *              stores up to `EZC_ULIST_CAPACITY` items instead of just one.
+ *              Walking the list therefore mostly reads consecutive memory
+ *              instead of taking a cache miss on every item. Since items are
+ *              not blocks of their own, functions hand out the item's data
+ *              rather than a pointer to the item. Blocks are allocated and
+ *              freed via the global allocator, see `ezc_mem_allocator`, as
+ *              there is no per-list allocator, so the global allocator must
+ *              not change while any list is alive.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_macro.h"
+#include <stdarg.h>
+#include <stddef.h>
+
+
+
+/** @def        EZC_ULIST_CAPACITY
+ *  @brief      Maximum number of items per block.
+ *  @details    The default makes a block exactly 128 bytes, i.e. two cache
+ *              lines, on 64-bit platforms. Can be overridden at compile time.
+ */
+#ifndef EZC_ULIST_CAPACITY
+#define EZC_ULIST_CAPACITY 14
+#endif
+
+
+
+/** @brief      Unrolled list block structure.
+ *  @details    A list is a chain of these blocks. Blocks are never empty.
+ */
+typedef struct ezc_ulist
+{
+    /** Pointer to next block in list. */
+    struct ezc_ulist *next;
+
+    /** Number of items stored in this block. */
+    long count;
+
+    /** Items' data. Only the first `count` are valid. */
+    void *data[EZC_ULIST_CAPACITY];
+}
+ezc_ulist;
+
+
+
+/** @brief      Initialize a list.
+ *  @details    Blank lists cannot be initialized. Attempting so will result
+ *              in this function returning `NULL`. Populate the list by
+ *              writing as many arguments as you want. For example,
+ *              `ezc_ulist *names = ezc_ulist_new("Adam", "Bob", "Carlos");`
+ *  @param      self    `void const *` First item of the list. You must provide
+ *                      at least one argument to this function.
+ *  @param      ...     `void const *` Optional additional list item arguments.
+ *  @returns    `ezc_ulist *` Pointer to allocated list.
+ */
+#define ezc_ulist_new(self, ...) \
+    (ezc_ulist_new__((self), ##__VA_ARGS__, NULL))
+
+ezc_ulist* ezc_ulist_new__(void const *data, ...);
+
+
+
+/** @brief      Create deep copy.
+ *  @param      orig    `ezc_ulist const *` Pointer to the list that you want
+ *                      copied.
+ *  @returns    `ezc_ulist *` Pointer to allocated list. If provided list was
+ *              `NULL`, returns `NULL`.
+ */
+#define ezc_ulist_copy(orig) \
+    (ezc_ulist_copy__((orig)))
+
+ezc_ulist* ezc_ulist_copy__(ezc_ulist const *orig);
+
+
+
+/** @brief      Join multiple lists (no new memory allocated).
+ *  @details    Attach tail-to-head the given lists.
+ *  @param      self    `ezc_ulist *` Pointer to the list you want to be the
+ *                      front-most.
+ *  @param      ...     `ezc_ulist *` Pointers to other lists in the order
+ *                      that you want them to be appended.
+ *  @returns    `ezc_ulist *` The head of the new list, which should equal the
+ *              first argument.
+ */
+#define ezc_ulist_cat(self, ...) \
+    (ezc_ulist_cat__((self), ##__VA_ARGS__, NULL))
+
+ezc_ulist* ezc_ulist_cat__(ezc_ulist *self, ...);
+
+
+
+/** @brief      Free given lists.
+ *  @details    Free the memory holding the lists. Also set the pointers to
+ *              equal `NULL` to help prevent dangling pointers.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      ...     `ezc_ulist *` Optional pointers to additional lists to
+ *                      be freed.
+ *  @returns    N/A
+ */
+#define ezc_ulist_delete(self, ...) \
+    (ezc_ulist_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_ulist_delete__(ezc_ulist *self, ...);
+
+
+
+/** @brief      Length of list.
+ *  @details    Only visits each block rather than each item.
+ *  @param      self    `ezc_ulist const *` Pointer to a list.
+ *  @returns    `long` Length of the given list.
+ */
+#define ezc_ulist_length(self) \
+    (ezc_ulist_length__((self)))
+
+long ezc_ulist_length__(ezc_ulist const *self);
+
+
+
+/** @brief      Apply function to each item of list.
+ *  @details    See `ezc_list_map` documentation.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      fn      Pointer to a function.
+ *  @param      ...     The arguments to be passed to `fn` following the
+ *                      item's data.
+ *  @returns    N/A
+ */
+#define ezc_ulist_map(self, fn, ...) \
+    do { ezc_ulist *iter = (self); while (iter != NULL) { long iter_i; \
+        for (iter_i = 0; iter_i < iter->count; iter_i++) \
+            (fn)(iter->data[iter_i], ##__VA_ARGS__); \
+        iter = iter->next; \
+    } } while(0)
+
+
+
+/** @brief      Get data at index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds.
+ *  @param      self    `ezc_ulist const *` Pointer to a list.
+ *  @param      n       `long` Index you want to look at.
+ *  @returns    `void *` Data of the item at index `n`. Returns `NULL` if any
+ *              problems occured.
+ */
+#define ezc_ulist_get_at(self, n) \
+    (ezc_ulist_get_at__((self), (n)))
+
+void* ezc_ulist_get_at__(ezc_ulist const *self, long n);
+
+
+
+/** @brief      Get index of item matching given data (via `!=` operator).
+ *  @param      self        `ezc_ulist const *` Pointer to a list.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          item to match.
+ *  @returns    `long` Index of the first matching item. Returns `-1` if no
+ *              item matched.
+ */
+#define ezc_ulist_get_index_of(self, data) \
+    (ezc_ulist_get_index_of_fn__((self), NULL, (data)))
+
+
+
+/** @brief      Get index of item matching given data (via custom comparison
+ *              function).
+ *  @param      self        `ezc_ulist const *` Pointer to a list.
+ *  @param      neq         Pointer to a function. See `ezc_list_get_match_fn`
+ *                          documentation.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          item to match.
+ *  @returns    `long` Index of the first matching item. Returns `-1` if no
+ *              item matched.
+ */
+#define ezc_ulist_get_index_of_fn(self, neq, data) \
+    (ezc_ulist_get_index_of_fn__((self), (neq), (data)))
+
+long ezc_ulist_get_index_of_fn__(ezc_ulist const *self,
+                                 int (*neq)(void const *, void const *),
+                                 void const *data);
+
+
+
+/** @brief      Get data matching given data (via custom comparison function).
+ *  @details    Useful when `neq` only compares part of the data, such as a
+ *              key.
+ *  @param      self        `ezc_ulist const *` Pointer to a list.
+ *  @param      neq         Pointer to a function. See `ezc_list_get_match_fn`
+ *                          documentation.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          fetched item to match.
+ *  @returns    `void *` Data of the first matching item. Returns `NULL` if no
+ *              item matched.
+ */
+#define ezc_ulist_get_match_fn(self, neq, data) \
+    (ezc_ulist_get_match_fn__((self), (neq), (data)))
+
+void* ezc_ulist_get_match_fn__(ezc_ulist const *self,
+                               int (*neq)(void const *, void const *),
+                               void const *data);
+
+
+
+/** @brief      Push items to index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds, with the exception
+ *              of `n == ezc_ulist_length(self)`. This case is valid and
+ *              equivalent to `ezc_ulist_push_back(self)`. If `self` is `NULL`
+ *              a new list is created.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      n       `long` Index you want the first pushed item to be at.
+ *  @param      ...     `void const *` Data you want to be pushed to the list.
+ *                      Provide as many as you want.
+ *  @returns    N/A
+ */
+#define ezc_ulist_push_at(self, n, ...) \
+    (ezc_ulist_push_at__(&(self), (n), ##__VA_ARGS__, NULL))
+
+void ezc_ulist_push_at__(ezc_ulist **self, long n, ...);
+
+
+
+/** @brief      Push items to the front.
+ *  @details    Equivalent to `ezc_ulist_push_at(self, 0, ...)`.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      ...     `void const *` Data you want to be pushed to the list.
+ *  @returns    N/A
+ */
+#define ezc_ulist_push_front(self, ...) \
+    (ezc_ulist_push_at__(&(self), 0, ##__VA_ARGS__, NULL))
+
+
+
+/** @brief      Push items to the back.
+ *  @details    Equivalent to
+ *              `ezc_ulist_push_at(self, ezc_ulist_length(self), ...)`.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      ...     `void const *` Data you want to be pushed to the list.
+ *  @returns    N/A
+ */
+#define ezc_ulist_push_back(self, ...) \
+    (ezc_ulist_push_at__(&(self), ezc_ulist_length__((self)), \
+                         ##__VA_ARGS__, NULL))
+
+
+
+/** @brief      Pop item at index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds. Blocks that become
+ *              empty are freed, and sparse neighboring blocks are merged.
+ *  @param      self    `ezc_ulist *` Pointer to a list. Becomes `NULL` once
+ *                      its last item is popped.
+ *  @param      n       `long` The index of the item you want to be popped.
+ *  @returns    `void *` Data of the item that got popped. Returns `NULL` if
+ *              any problems occured.
+ */
+#define ezc_ulist_pop_at(self, n) \
+    (ezc_ulist_pop_at__(&(self), (n)))
+
+void* ezc_ulist_pop_at__(ezc_ulist **self, long n);
+
+
+
+/** @brief      Pop first item.
+ *  @details    Equivalent to `ezc_ulist_pop_at(self, 0)`.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @returns    `void *` Data of the item that got popped.
+ */
+#define ezc_ulist_pop_front(self) \
+    (ezc_ulist_pop_at__(&(self), 0))
+
+
+
+/** @brief      Pop last item.
+ *  @details    Equivalent to
+ *              `ezc_ulist_pop_at(self, ezc_ulist_length(self)-1)`.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @returns    `void *` Data of the item that got popped.
+ */
+#define ezc_ulist_pop_back(self) \
+    (ezc_ulist_pop_at__(&(self), ezc_ulist_length__((self))-1))
+
+
+
+/** @brief      Pop item matching given data (via `!=` operator).
+ *  @param      self        `ezc_ulist *` Pointer to a list.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          popped item to match.
+ *  @returns    `void *` Data of the popped first matching item. Returns `NULL`
+ *              if no item matched.
+ */
+#define ezc_ulist_pop_match(self, data) \
+    (ezc_ulist_pop_match_fn__(&(self), NULL, (data)))
+
+
+
+/** @brief      Pop item matching given data (via custom comparison function).
+ *  @param      self        `ezc_ulist *` Pointer to a list.
+ *  @param      neq         Pointer to a function. See `ezc_list_get_match_fn`
+ *                          documentation. Pass `NULL` to compare via `!=`.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          popped item to match.
+ *  @returns    `void *` Data of the popped first matching item. Returns `NULL`
+ *              if no item matched.
+ */
+#define ezc_ulist_pop_match_fn(self, neq, data) \
+    (ezc_ulist_pop_match_fn__(&(self), (neq), (data)))
+
+void* ezc_ulist_pop_match_fn__(ezc_ulist **self,
+                               int (*neq)(void const *, void const *),
+                               void const *data);
+
+
+
+/** @brief      Erase item at index `n`.
+ *  @details    The item's data itself is not freed.
+ *  @param      self    `ezc_ulist *` Pointer to a list.
+ *  @param      n       `long` The index of the item you want to be erased.
+ *  @returns    N/A
+ */
+#define ezc_ulist_erase_at(self, n) \
+    ((void) ezc_ulist_pop_at__(&(self), (n)))
+
+
+
+/** @brief      Erase item matching given data (via `!=` operator).
+ *  @param      self        `ezc_ulist *` Pointer to a list.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          erased item to match.
+ *  @returns    N/A
+ */
+#define ezc_ulist_erase_match(self, data) \
+    ((void) ezc_ulist_pop_match_fn__(&(self), NULL, (data)))
+
+
+
+/** @brief      Erase item matching given data (via custom comparison
+ *              function).
+ *  @param      self        `ezc_ulist *` Pointer to a list.
+ *  @param      neq         Pointer to a function. Pass `NULL` to compare via
+ *                          `!=`.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          erased item to match.
+ *  @returns    N/A
+ */
+#define ezc_ulist_erase_match_fn(self, neq, data) \
+    ((void) ezc_ulist_pop_match_fn__(&(self), (neq), (data)))
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_ULIST_H */
@@ -0,0 +1,350 @@
+/*  ezc_vec.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "ezc/ezc_vec.h"
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+/* Smallest capacity a non-empty vector grows to. */
+static long const EZC_VEC_MIN_CAPACITY = 8;
+
+
+
+/* Grow so that `n` items fit, at least doubling to keep pushes amortized
+ * O(1). Returns 0 on failure. */
+static int ezc_vec_grow(ezc_vec *self, long n)
+{
+    if (n > self->capacity)
+    {
+        long capacity = self->capacity * 2;
+
+        if (capacity < EZC_VEC_MIN_CAPACITY) capacity = EZC_VEC_MIN_CAPACITY;
+        if (capacity < n) capacity = n;
+
+        ezc_vec_reserve__(self, capacity);
+    }
+
+    return n <= self->capacity;
+}
+
+
+
+static ezc_vec* ezc_vec_create(ezc_allocator const *allocator)
+{
+    ezc_vec *self = EZC_MEM_ALLOC(allocator, sizeof *self);
+
+    if (self == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to allocate vector.");
+        return NULL;
+    }
+
+    self->data = NULL;
+    self->length = 0;
+    self->capacity = 0;
+    self->allocator = allocator;
+
+    return self;
+}
+
+
+
+static void ezc_vec_fill(ezc_vec *self, void const *data, va_list arg_ptr)
+{
+    while (data != NULL)
+    {
+        if (!ezc_vec_grow(self, self->length + 1)) break;
+
+        self->data[self->length++] = (void *) data;
+        data = va_arg(arg_ptr, void const *);
+    }
+}
+
+
+
+ezc_vec* ezc_vec_new__(void const *data, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, data);
+
+    ezc_vec * const self = ezc_vec_create(EZC_MEM_GLOBAL);
+    if (self != NULL) ezc_vec_fill(self, data, arg_ptr);
+
+    va_end(arg_ptr);
+    return self;
+}
+
+
+
+ezc_vec* ezc_vec_new_allocator__(ezc_allocator const *allocator, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, allocator);
+
+    ezc_vec * const self = ezc_vec_create(allocator != NULL ? allocator :
+            EZC_MEM_GLOBAL);
+    if (self != NULL)
+    {
+        ezc_vec_fill(self, va_arg(arg_ptr, void const *), arg_ptr);
+    }
+
+    va_end(arg_ptr);
+    return self;
+}
+
+
+
+ezc_vec* ezc_vec_copy__(ezc_vec const *orig)
+{
+    ezc_vec *self = NULL;
+
+    if (orig != NULL)
+    {
+        self = ezc_vec_create(orig->allocator);
+
+        if (self != NULL)
+        {
+            ezc_vec_push_array__(self, 0, orig->data, orig->length);
+        }
+    }
+
+    return self;
+}
+
+
+
+void ezc_vec_delete__(ezc_vec *self, ...)
+{
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    while (self != NULL)
+    {
+        ezc_allocator const * const ALLOCATOR = self->allocator;
+
+        EZC_MEM_FREE(ALLOCATOR, self->data);
+        EZC_MEM_FREE(ALLOCATOR, self);
+
+        self = va_arg(arg_ptr, ezc_vec*);
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_vec_reserve__(ezc_vec *self, long n)
+{
+    assert(self != NULL && n >= 0);
+
+    if (n > self->capacity)
+    {
+        void **data = ezc_vec_grow_raw__(self->allocator, self->data, n,
+                sizeof *data);
+
+        if (data != NULL)
+        {
+            self->data = data;
+            self->capacity = n;
+        }
+    }
+}
+
+
+
+void* ezc_vec_grow_raw__(ezc_allocator const *allocator, void *data, long n,
+                         size_t size)
+{
+    void *grown = NULL;
+
+    if (n > 0 && (size_t) n <= (size_t) -1 / size)
+    {
+        grown = EZC_MEM_REALLOC(allocator, data, n * size);
+    }
+
+    if (grown == NULL)
+    {
+        ezc_log(EZC_LOG_ERROR, "Unable to grow vector to %li items.", n);
+    }
+
+    return grown;
+}
+
+
+
+void ezc_vec_shrink_to_fit__(ezc_vec *self)
+{
+    assert(self != NULL);
+
+    if (self->length == 0)
+    {
+        EZC_MEM_FREE(self->allocator, self->data);
+        self->data = NULL;
+        self->capacity = 0;
+    }
+    else if (self->length < self->capacity)
+    {
+        void **data = EZC_MEM_REALLOC(self->allocator, self->data,
+                self->length * sizeof *data);
+
+        /* On failure simply keep the larger block */
+        if (data != NULL)
+        {
+            self->data = data;
+            self->capacity = self->length;
+        }
+    }
+}
+
+
+
+void* ezc_vec_get_at__(ezc_vec const *self, long n)
+{
+    assert(self != NULL && n >= 0 && n < self->length);
+    return self->data[n];
+}
+
+
+
+void ezc_vec_set_at__(ezc_vec *self, long n, void const *data)
+{
+    assert(self != NULL && n >= 0 && n < self->length);
+    self->data[n] = (void *) data;
+}
+
+
+
+long ezc_vec_get_index_of_fn__(ezc_vec const *self,
+                               int (*neq)(void const *, void const *),
+                               void const *data)
+{
+    long i;
+
+    if (neq == NULL)
+    {
+        for (i = 0; i < self->length; i++)
+        {
+            if (self->data[i] == data) return i;
+        }
+    }
+    else
+    {
+        for (i = 0; i < self->length; i++)
+        {
+            if (!(*neq)(self->data[i], data)) return i;
+        }
+    }
+
+    return -1;
+}
+
+
+
+void ezc_vec_push_at__(ezc_vec *self, long n, ...)
+{
+    /* Pushing at vector length is valid. This is equivalent to push_back. */
+    assert(self != NULL && n >= 0 && n <= self->length);
+
+    va_list arg_ptr;
+    va_start(arg_ptr, n);
+
+    void *data;
+    long count = 0;
+
+    /* Count first so the tail gets shifted only once */
+    while (va_arg(arg_ptr, void const *) != NULL) count++;
+    va_end(arg_ptr);
+
+    if (count > 0 && ezc_vec_grow(self, self->length + count))
+    {
+        memmove(&self->data[n + count], &self->data[n],
+                (self->length - n) * sizeof *self->data);
+        self->length += count;
+
+        va_start(arg_ptr, n);
+
+        while ((data = va_arg(arg_ptr, void *)) != NULL)
+        {
+            self->data[n++] = data;
+        }
+
+        va_end(arg_ptr);
+    }
+}
+
+
+
+void ezc_vec_push_back__(ezc_vec *self, ...)
+{
+    assert(self != NULL);
+
+    va_list arg_ptr;
+    va_start(arg_ptr, self);
+
+    void *data;
+
+    while ((data = va_arg(arg_ptr, void *)) != NULL)
+    {
+        if (!ezc_vec_grow(self, self->length + 1)) break;
+        self->data[self->length++] = data;
+    }
+
+    va_end(arg_ptr);
+}
+
+
+
+void ezc_vec_push_array__(ezc_vec *self, long n, void * const *array,
+                          long count)
+{
+    assert(self != NULL && n >= 0 && n <= self->length && count >= 0);
+
+    if (count > 0 && ezc_vec_grow(self, self->length + count))
+    {
+        memmove(&self->data[n + count], &self->data[n],
+                (self->length - n) * sizeof *self->data);
+        memcpy(&self->data[n], array, count * sizeof *self->data);
+        self->length += count;
+    }
+}
+
+
+
+void* ezc_vec_pop_at__(ezc_vec *self, long n)
+{
+    assert(self != NULL && n >= 0 && n < self->length);
+
+    void *popped = self->data[n];
+
+    self->length--;
+    memmove(&self->data[n], &self->data[n + 1],
+            (self->length - n) * sizeof *self->data);
+
+    return popped;
+}
@@ -0,0 +1,552 @@
+/*  ezc_vec.h
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef EZC_VEC_H
+#define EZC_VEC_H
+
+/** @file       ezc_vec.h
+ *  @brief      Contiguous growable array implementation.
+ *  @details    Stores `void *` data just like `ezc_list`, but in one block of
+ *              memory. Random access is `O(1)` and pushing/popping at the
+ *              back is amortized `O(1)`. Prefer this over `ezc_list` whenever
+ *              you mostly index into or append to your data.
+ */
+
+#ifdef __cplusplus
+extern C
+{
+#endif
+
+#include "ezc/ezc_assert.h"
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+
+
+/** @brief      Vector structure.
+ *  @details    Feel free to read the members directly, e.g. to iterate over
+ *              `data` yourself, but only modify them via the functions below.
+ */
+typedef struct ezc_vec
+{
+    /** Items' data. Only the first `length` are valid. */
+    void **data;
+
+    /** Number of items in the vector. */
+    long length;
+
+    /** Number of items that fit in `data` before it must grow. */
+    long capacity;
+
+    /** Allocator of the vector and `data`. `NULL` for the standard
+     *  library. */
+    ezc_allocator const *allocator;
+}
+ezc_vec;
+
+
+
+/** @brief      Initialize a vector.
+ *  @details    Unlike `ezc_list_new`, blank vectors are allowed, i.e.
+ *              `ezc_vec_new(NULL)`. Otherwise populate the vector by writing
+ *              as many arguments as you want. For example,
+ *              `ezc_vec *names = ezc_vec_new("Adam", "Bob", "Carlos");`
+ *  @param      self    `void const *` First item of the vector, or `NULL`.
+ *  @param      ...     `void const *` Optional additional item arguments.
+ *  @returns    `ezc_vec *` Pointer to allocated vector.
+ */
+#define ezc_vec_new(self, ...) \
+    (ezc_vec_new__((self), ##__VA_ARGS__, NULL))
+
+ezc_vec* ezc_vec_new__(void const *data, ...);
+
+
+
+/** @brief      Initialize a vector that uses the given allocator.
+ *  @details    Works just like `ezc_vec_new`, but the vector and its items'
+ *              array are allocated via `allocator` rather than the global
+ *              allocator, see `ezc_mem_allocator`. Copies use it as well.
+ *  @param      allocator   `ezc_allocator const *` Allocator, which must
+ *                          outlive the vector. `NULL` for the global one.
+ *  @param      ...         `void const *` Optional item arguments.
+ *  @returns    `ezc_vec *` Pointer to allocated vector.
+ */
+#define ezc_vec_new_allocator(allocator, ...) \
+    (ezc_vec_new_allocator__((allocator), ##__VA_ARGS__, NULL))
+
+ezc_vec* ezc_vec_new_allocator__(ezc_allocator const *allocator, ...);
+
+
+
+/** @brief      Create deep copy.
+ *  @details    The copy's capacity equals the original's length.
+ *  @param      orig    `ezc_vec const *` Pointer to the vector that you want
+ *                      copied.
+ *  @returns    `ezc_vec *` Pointer to allocated vector. If provided vector was
+ *              `NULL`, returns `NULL`.
+ */
+#define ezc_vec_copy(orig) \
+    (ezc_vec_copy__((orig)))
+
+ezc_vec* ezc_vec_copy__(ezc_vec const *orig);
+
+
+
+/** @brief      Free given vectors.
+ *  @details    Free the memory holding the vectors. Also set the pointers to
+ *              equal `NULL` to help prevent dangling pointers. The items'
+ *              data itself is not freed.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      ...     `ezc_vec *` Optional pointers to additional vectors to
+ *                      be freed.
+ *  @returns    N/A
+ */
+#define ezc_vec_delete(self, ...) \
+    (ezc_vec_delete__((self), ##__VA_ARGS__, NULL), \
+     SST_MAP_LIST(EZC_TO_ZERO, (self), ##__VA_ARGS__))
+
+void ezc_vec_delete__(ezc_vec *self, ...);
+
+
+
+/** @brief      Length of vector.
+ *  @param      self    `ezc_vec const *` Pointer to a vector.
+ *  @returns    `long` Length of the given vector.
+ */
+#define ezc_vec_length(self) \
+    ((self)->length)
+
+
+
+/** @brief      Capacity of vector.
+ *  @param      self    `ezc_vec const *` Pointer to a vector.
+ *  @returns    `long` Number of items the vector can hold without
+ *              reallocating.
+ */
+#define ezc_vec_capacity(self) \
+    ((self)->capacity)
+
+
+
+/** @brief      Make room for at least `n` items.
+ *  @details    Does nothing if the capacity already suffices. Logs an
+ *              `EZC_LOG_ERROR` if the memory could not be allocated.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` Capacity you want the vector to have at least.
+ *  @returns    N/A
+ */
+#define ezc_vec_reserve(self, n) \
+    (ezc_vec_reserve__((self), (n)))
+
+void ezc_vec_reserve__(ezc_vec *self, long n);
+
+
+
+/** @brief      Release unused capacity.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @returns    N/A
+ */
+#define ezc_vec_shrink_to_fit(self) \
+    (ezc_vec_shrink_to_fit__((self)))
+
+void ezc_vec_shrink_to_fit__(ezc_vec *self);
+
+
+
+/** @brief      Remove all items.
+ *  @details    The capacity is left untouched.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @returns    N/A
+ */
+#define ezc_vec_clear(self) \
+    ((void) ((self)->length = 0))
+
+
+
+/** @brief      Apply function to each item of vector.
+ *  @details    See `ezc_list_map` documentation.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      fn      Pointer to a function.
+ *  @param      ...     The arguments to be passed to `fn` following the
+ *                      item's data.
+ *  @returns    N/A
+ */
+#define ezc_vec_map(self, fn, ...) \
+    do { ezc_vec *iter = (self); long iter_i; \
+        for (iter_i = 0; iter_i < iter->length; iter_i++) \
+            (fn)(iter->data[iter_i], ##__VA_ARGS__); \
+    } while(0)
+
+
+
+/** @brief      Get data at index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds.
+ *  @param      self    `ezc_vec const *` Pointer to a vector.
+ *  @param      n       `long` Index you want to look at.
+ *  @returns    `void *` Data of the item at index `n`.
+ */
+#define ezc_vec_get_at(self, n) \
+    (ezc_vec_get_at__((self), (n)))
+
+void* ezc_vec_get_at__(ezc_vec const *self, long n);
+
+
+
+/** @brief      Set data at index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` Index you want to overwrite.
+ *  @param      data    `void const *` New data of the item.
+ *  @returns    N/A
+ */
+#define ezc_vec_set_at(self, n, data) \
+    (ezc_vec_set_at__((self), (n), (data)))
+
+void ezc_vec_set_at__(ezc_vec *self, long n, void const *data);
+
+
+
+/** @brief      Get index of item matching given data (via `!=` operator).
+ *  @param      self        `ezc_vec const *` Pointer to a vector.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          item to match.
+ *  @returns    `long` Index of the first matching item. Returns `-1` if no
+ *              item matched.
+ */
+#define ezc_vec_get_index_of(self, data) \
+    (ezc_vec_get_index_of_fn__((self), NULL, (data)))
+
+
+
+/** @brief      Get index of item matching given data (via custom comparison
+ *              function).
+ *  @param      self        `ezc_vec const *` Pointer to a vector.
+ *  @param      neq         Pointer to a function. See `ezc_list_get_match_fn`
+ *                          documentation.
+ *  @param      data        `void const *` Pointer to data that you want the
+ *                          item to match.
+ *  @returns    `long` Index of the first matching item. Returns `-1` if no
+ *              item matched.
+ */
+#define ezc_vec_get_index_of_fn(self, neq, data) \
+    (ezc_vec_get_index_of_fn__((self), (neq), (data)))
+
+long ezc_vec_get_index_of_fn__(ezc_vec const *self,
+                               int (*neq)(void const *, void const *),
+                               void const *data);
+
+
+
+/** @brief      Push items to index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds, with the exception
+ *              of `n == ezc_vec_length(self)`. This case is valid and
+ *              equivalent to `ezc_vec_push_back(self)`.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` Index you want the first pushed item to be at.
+ *  @param      ...     `void const *` Data you want to be pushed to the
+ *                      vector. Provide as many as you want.
+ *  @returns    N/A
+ */
+#define ezc_vec_push_at(self, n, ...) \
+    (ezc_vec_push_at__((self), (n), ##__VA_ARGS__, NULL))
+
+void ezc_vec_push_at__(ezc_vec *self, long n, ...);
+
+
+
+/** @brief      Push items to the front.
+ *  @details    Equivalent to `ezc_vec_push_at(self, 0, ...)`. This is `O(n)`.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      ...     `void const *` Data you want to be pushed.
+ *  @returns    N/A
+ */
+#define ezc_vec_push_front(self, ...) \
+    (ezc_vec_push_at__((self), 0, ##__VA_ARGS__, NULL))
+
+
+
+/** @brief      Push items to the back.
+ *  @details    Amortized `O(1)` per item.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      ...     `void const *` Data you want to be pushed.
+ *  @returns    N/A
+ */
+#define ezc_vec_push_back(self, ...) \
+    (ezc_vec_push_back__((self), ##__VA_ARGS__, NULL))
+
+void ezc_vec_push_back__(ezc_vec *self, ...);
+
+
+
+/** @brief      Push a C array of items to index `n`.
+ *  @details    Same as `ezc_vec_push_at`, except the data comes from an
+ *              array and may therefore contain `NULL`. The vector grows at
+ *              most once.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` Index you want the first pushed item to be at.
+ *  @param      array   `void * const *` Array holding the data.
+ *  @param      count   `long` Number of items in `array`.
+ *  @returns    N/A
+ */
+#define ezc_vec_push_array(self, n, array, count) \
+    (ezc_vec_push_array__((self), (n), (void * const *) (array), (count)))
+
+void ezc_vec_push_array__(ezc_vec *self, long n, void * const *array,
+                          long count);
+
+
+
+/** @brief      Pop item at index `n`.
+ *  @details    Asserts that `n` must be not out-of-bounds. Following items
+ *              are shifted down, so this is `O(n)` except at the back.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` The index of the item you want to be popped.
+ *  @returns    `void *` Data of the item that got popped.
+ */
+#define ezc_vec_pop_at(self, n) \
+    (ezc_vec_pop_at__((self), (n)))
+
+void* ezc_vec_pop_at__(ezc_vec *self, long n);
+
+
+
+/** @brief      Pop first item.
+ *  @details    Equivalent to `ezc_vec_pop_at(self, 0)`.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @returns    `void *` Data of the item that got popped.
+ */
+#define ezc_vec_pop_front(self) \
+    (ezc_vec_pop_at__((self), 0))
+
+
+
+/** @brief      Pop last item.
+ *  @details    `O(1)`. Equivalent to
+ *              `ezc_vec_pop_at(self, ezc_vec_length(self)-1)`.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @returns    `void *` Data of the item that got popped.
+ */
+#define ezc_vec_pop_back(self) \
+    (ezc_vec_pop_at__((self), (self)->length-1))
+
+
+
+/** @brief      Erase item at index `n`.
+ *  @details    The item's data itself is not freed.
+ *  @param      self    `ezc_vec *` Pointer to a vector.
+ *  @param      n       `long` The index of the item you want to be erased.
+ *  @returns    N/A
+ */
+#define ezc_vec_erase_at(self, n) \
+    ((void) ezc_vec_pop_at__((self), (n)))
+
+
+
+/** @brief      Define a vector type that stores items of the given type.
+ *  @details    `ezc_vec` stores pointers, so storing numbers or small
+ *              structures takes an allocation per item and a detour on each
+ *              access. Vectors defined by this macro store the items
+ *              themselves, one after another. For example,
+ *              `EZC_VEC_DEFINE(point_vec, struct point)` defines the type
+ *              `point_vec` along with these functions, which work just like
+ *              their `ezc_vec` counterparts:
+ *              - `point_vec* point_vec_new()`
+ *              - `void point_vec_delete(point_vec *self)`
+ *              - `long point_vec_length(point_vec const *self)`
+ *              - `void point_vec_reserve(point_vec *self, long n)`
+ *              - `void point_vec_shrink_to_fit(point_vec *self)`
+ *              - `void point_vec_clear(point_vec *self)`
+ *              - `struct point* point_vec_get_at(point_vec const *self,
+ *                                                long n)`
+ *              - `void point_vec_set_at(point_vec *self, long n,
+ *                                       struct point data)`
+ *              - `struct point* point_vec_push_at(point_vec *self, long n,
+ *                                                 struct point data)`
+ *              - `struct point* point_vec_push_back(point_vec *self,
+ *                                                   struct point data)`
+ *              - `struct point point_vec_pop_at(point_vec *self, long n)`
+ *              - `struct point point_vec_pop_back(point_vec *self)`
+ *
+ *              Pushing returns a pointer to the pushed item, or `NULL` if the
+ *              vector could not grow. Pointers to items stay valid until the
+ *              vector grows or shrinks. The functions are `static`, so the
+ *              macro can be used in a header, and functions a file does not
+ *              call cause no warnings.
+ *  @param      name    Name of the vector type.
+ *  @param      type    Type of the items.
+ */
+#define EZC_VEC_DEFINE(name, type) \
+    typedef struct name \
+    { \
+        type *data; \
+        long length; \
+        long capacity; \
+        ezc_allocator const *allocator; \
+    } \
+    name; \
+    \
+    static EZC_UNUSED name* name##_new() \
+    { \
+        name *self = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, sizeof *self); \
+        \
+        if (self != NULL) \
+        { \
+            self->data = NULL; \
+            self->length = 0; \
+            self->capacity = 0; \
+            self->allocator = EZC_MEM_GLOBAL; \
+        } \
+        \
+        return self; \
+    } \
+    \
+    static EZC_UNUSED void name##_delete(name *self) \
+    { \
+        if (self != NULL) \
+        { \
+            ezc_allocator const * const ALLOCATOR = self->allocator; \
+            \
+            EZC_MEM_FREE(ALLOCATOR, self->data); \
+            EZC_MEM_FREE(ALLOCATOR, self); \
+        } \
+    } \
+    \
+    static EZC_UNUSED long name##_length(name const *self) \
+    { \
+        return self->length; \
+    } \
+    \
+    static EZC_UNUSED void name##_reserve(name *self, long n) \
+    { \
+        assert(self != NULL && n >= 0); \
+        \
+        if (n > self->capacity) \
+        { \
+            type *data = ezc_vec_grow_raw__(self->allocator, self->data, \
+                    n, sizeof *data); \
+            \
+            if (data != NULL) \
+            { \
+                self->data = data; \
+                self->capacity = n; \
+            } \
+        } \
+    } \
+    \
+    static EZC_UNUSED void name##_shrink_to_fit(name *self) \
+    { \
+        assert(self != NULL); \
+        \
+        if (self->length == 0) \
+        { \
+            EZC_MEM_FREE(self->allocator, self->data); \
+            self->data = NULL; \
+            self->capacity = 0; \
+        } \
+        else if (self->length < self->capacity) \
+        { \
+            type *data = EZC_MEM_REALLOC(self->allocator, self->data, \
+                    self->length * sizeof *data); \
+            \
+            if (data != NULL) \
+            { \
+                self->data = data; \
+                self->capacity = self->length; \
+            } \
+        } \
+    } \
+    \
+    static EZC_UNUSED void name##_clear(name *self) \
+    { \
+        self->length = 0; \
+    } \
+    \
+    static EZC_UNUSED type* name##_get_at(name const *self, long n) \
+    { \
+        assert(self != NULL && n >= 0 && n < self->length); \
+        return &self->data[n]; \
+    } \
+    \
+    static EZC_UNUSED void name##_set_at(name *self, long n, type data) \
+    { \
+        assert(self != NULL && n >= 0 && n < self->length); \
+        self->data[n] = data; \
+    } \
+    \
+    static EZC_UNUSED type* name##_push_at(name *self, long n, type data) \
+    { \
+        assert(self != NULL && n >= 0 && n <= self->length); \
+        \
+        if (self->length == self->capacity) \
+        { \
+            name##_reserve(self, self->capacity > 0 ? \
+                    self->capacity * 2 : 8); \
+            if (self->length == self->capacity) return NULL; \
+        } \
+        \
+        memmove(&self->data[n + 1], &self->data[n], \
+                (self->length - n) * sizeof *self->data); \
+        self->data[n] = data; \
+        self->length++; \
+        \
+        return &self->data[n]; \
+    } \
+    \
+    static EZC_UNUSED type* name##_push_back(name *self, type data) \
+    { \
+        return name##_push_at(self, self->length, data); \
+    } \
+    \
+    static EZC_UNUSED type name##_pop_at(name *self, long n) \
+    { \
+        type popped; \
+        \
+        assert(self != NULL && n >= 0 && n < self->length); \
+        \
+        popped = self->data[n]; \
+        self->length--; \
+        memmove(&self->data[n], &self->data[n + 1], \
+                (self->length - n) * sizeof *self->data); \
+        \
+        return popped; \
+    } \
+    \
+    static EZC_UNUSED type name##_pop_back(name *self) \
+    { \
+        assert(self != NULL && self->length > 0); \
+        return self->data[--self->length]; \
+    }
+
+/* Resize `data` to `n` items of `size` bytes. Logs and returns `NULL` on
+ * failure, in which case `data` is left alone. */
+void* ezc_vec_grow_raw__(ezc_allocator const *allocator, void *data, long n,
+                         size_t size);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EZC_VEC_H */
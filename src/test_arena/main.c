@@ -0,0 +1,94 @@
+/*  test_arena/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_arena/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_arena.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+#include <string.h>
+
+
+
+typedef struct point
+{
+    double x, y;
+}
+point;
+
+
+
+int main(int argc, char *argv[])
+{
+    ezc_arena *arena = ezc_arena_new(1024);
+    ezc_arena_mark mark;
+    point *p, *points;
+    char *big, *start;
+    long i, errors = 0;
+
+    EZC_ARENA_NEW(arena, p);
+    p->x = 1.0;
+    p->y = 2.0;
+    printf("Point: (%.1f, %.1f)\n", p->x, p->y);
+
+    EZC_ARENA_NEWN(arena, points, 10);
+    for (i = 0; i < 10; i++) if (points[i].x != 0.0) errors++;
+
+    printf("Aligning...\n");
+    for (i = 1; i <= 256; i *= 2)
+    {
+        char *c = ezc_arena_alloc(arena, 1, 0);
+        void *aligned = ezc_arena_alloc(arena, 3, i);
+
+        if ((unsigned long) aligned % i != 0 || (char *) aligned <= c) errors++;
+    }
+
+    printf("Rewinding...\n");
+    mark = ezc_arena_save(arena);
+
+    /* Spills over into several chunks, one of them oversized */
+    for (i = 0; i < 100; i++) EZC_ARENA_NEWN(arena, points, 10);
+    big = ezc_arena_alloc(arena, 10000, 0);
+    memset(big, 'x', 10000);
+
+    ezc_arena_rewind(arena, mark);
+    if (arena->chunk != mark.chunk || arena->cursor != mark.cursor) errors++;
+    if (p->x != 1.0) errors++;
+
+    printf("Releasing...\n");
+    ezc_arena_release(arena);
+    if (arena->chunk == NULL) errors++;
+
+    /* The oldest chunk is reused right away, from its very start */
+    start = arena->cursor;
+    EZC_ARENA_NEW0(arena, points);
+    if ((char *) points != start || points->y != 0.0) errors++;
+
+    if (ezc_arena_calloc(arena, -1, 1) != NULL) errors++;
+
+    printf("-- errors=%li --\n", errors);
+    ezc_arena_delete(arena);
+
+    return errors != 0 || arena != NULL;
+}
@@ -26,11 +26,38 @@
 
 #include "ezc/ezc_callback.h"
 #include "ezc/ezc_list.h"
+#include "ezc/ezc_log.h"
+#include "ezc/ezc_mem.h"
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define PI 3.14159265358979323846
 
+static long calls = 0;
+
+
+
+static void* failing_alloc(void *context, size_t size)
+{
+    return NULL;
+}
+
+
+
+static void* failing_realloc(void *context, void *ptr, size_t size)
+{
+    return NULL;
+}
+
+
+
+static void failing_free(void *context, void *ptr)
+{
+    free(ptr);
+}
+
 
 
 void printCircleArea(double *r)
@@ -40,11 +67,57 @@ void printCircleArea(double *r)
 
 
 
+void count(long *n)
+{
+    (*n)++;
+}
+
+
+
+/* Frees callbacks made by another thread, then churns through its own */
+void* churn(void *made)
+{
+    ezc_callback **callbacks = made;
+    long i;
+
+    for (i = 0; i < 1000; i++) ezc_callback_delete(callbacks[i]);
+
+    for (i = 0; i < 100000; i++)
+    {
+        ezc_callback *callback = ezc_callback_new(count, &calls);
+        ezc_callback_delete(callback);
+    }
+
+    return NULL;
+}
+
+
+
 int main(int argc, char *argv[])
 {
     double radii[3] = { 1.0, 2.0, 3.0 };
+    ezc_list *circles;
 
-    ezc_list *circles = ezc_list_new(
+
+    {
+        /* Without memory for the pool there are no callbacks, until there
+         * is memory again */
+        ezc_allocator failing =
+        {
+            failing_alloc, failing_realloc, failing_free, NULL
+        };
+        ezc_allocator const * const GLOBAL = EZC_MEM_GLOBAL;
+
+        /* The log needs memory of its own to report the failure */
+        ezc_log(EZC_LOG_INFO, "Running out of memory on purpose.");
+
+        ezc_mem_allocator(&failing);
+        if (ezc_callback_new(count, &calls) != NULL) return 1;
+        ezc_mem_allocator(GLOBAL);
+    }
+
+
+    circles = ezc_list_new(
             ezc_callback_new(printCircleArea, &radii[0]),
             ezc_callback_new(printCircleArea, &radii[1]),
             ezc_callback_new(printCircleArea, &radii[2]));
@@ -54,5 +127,54 @@ int main(int argc, char *argv[])
     ezc_list_map(circles, ezc_callback_delete);
     ezc_list_delete(circles);
 
+
+    {
+        /* The same, but kept by value and performed in one go */
+        ezc_callback inline_circles[3];
+        ezc_callback counter = EZC_CALLBACK(count, &calls);
+        static ezc_callback counters[1000];
+        long i;
+
+        for (i = 0; i < 3; i++)
+        {
+            ezc_callback_init(&inline_circles[i],
+                    (void (*)(void*)) printCircleArea, &radii[i]);
+        }
+
+        ezc_callback_call_batch(inline_circles, 3);
+
+        for (i = 0; i < EZC_LENGTH(counters); i++) counters[i] = counter;
+        for (i = 0; i < 1000; i++)
+        {
+            ezc_callback_call_batch(counters, EZC_LENGTH(counters));
+        }
+
+        printf("-- calls=%li --\n", calls);
+        if (calls != 1000L * EZC_LENGTH(counters)) return 1;
+    }
+
+
+    {
+        /* Callbacks come from a pool shared across threads */
+        static ezc_callback *made[1000];
+        pthread_t thread;
+        long i;
+
+        for (i = 0; i < EZC_LENGTH(made); i++)
+        {
+            made[i] = ezc_callback_new(count, &calls);
+        }
+
+        pthread_create(&thread, NULL, churn, made);
+
+        for (i = 0; i < 100000; i++)
+        {
+            ezc_callback *callback = ezc_callback_new(count, &calls);
+            ezc_callback_delete(callback);
+        }
+
+        pthread_join(thread, NULL);
+    }
+
     return 0;
 }
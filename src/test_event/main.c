@@ -0,0 +1,138 @@
+/*  test_event/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_event/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_event.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+
+
+
+static ezc_event *BUS;
+static ezc_event_handle HANDLES[1000];
+
+
+
+void print_temperature(char *city, double *celsius)
+{
+    printf("[%s]: %.1f C\n", city, *celsius);
+}
+
+
+
+void count(long *calls, void *data)
+{
+    (*calls)++;
+}
+
+
+
+/* Unsubscribes itself and its neighbor, and subscribes a newcomer */
+void meddle(long *calls, void *data)
+{
+    (*calls)++;
+
+    ezc_event_unsubscribe(BUS, HANDLES[0]);
+    ezc_event_unsubscribe(BUS, HANDLES[1]);
+    HANDLES[2] = ezc_event_subscribe(BUS, "meddle", (void (*)(void*, void*))
+            count, calls);
+}
+
+
+
+/* Publishes on its own topic once more from within */
+void recurse(long *calls, void *data)
+{
+    if ((*calls)++ == 0) ezc_event_publish(BUS, "recurse", data);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    double celsius = 21.5;
+    long calls = 0, i;
+
+    BUS = ezc_event_new();
+
+    ezc_event_subscribe(BUS, "weather", (void (*)(void*, void*))
+            print_temperature, "Berlin");
+    ezc_event_subscribe(BUS, "weather", (void (*)(void*, void*))
+            print_temperature, "Tokyo");
+    if (ezc_event_publish(BUS, "weather", &celsius) != 2) return 1;
+    if (ezc_event_publish(BUS, "nobody", &celsius) != 0) return 1;
+
+    printf("Unsubscribing while publishing...\n");
+    HANDLES[0] = ezc_event_subscribe(BUS, "meddle", (void (*)(void*, void*))
+            meddle, &calls);
+    HANDLES[1] = ezc_event_subscribe(BUS, "meddle", (void (*)(void*, void*))
+            count, &calls);
+
+    /* The neighbor is gone before its turn, the newcomer waits */
+    if (ezc_event_publish(BUS, "meddle", NULL) != 1 || calls != 1) return 1;
+    if (ezc_event_length(BUS, "meddle") != 1) return 1;
+    if (ezc_event_publish(BUS, "meddle", NULL) != 1 || calls != 2) return 1;
+    if (ezc_event_unsubscribe(BUS, HANDLES[0]) != -1) return 1;
+    if (ezc_event_unsubscribe(BUS, HANDLES[2]) != 0) return 1;
+    if (ezc_event_length(BUS, "meddle") != 0) return 1;
+
+    printf("Publishing recursively...\n");
+    calls = 0;
+    ezc_event_subscribe(BUS, "recurse", (void (*)(void*, void*)) recurse,
+            &calls);
+    if (ezc_event_publish(BUS, "recurse", NULL) != 1 || calls != 2) return 1;
+
+    printf("Unsubscribing every other one of %li...\n",
+            (long) EZC_LENGTH(HANDLES));
+    calls = 0;
+
+    for (i = 0; i < EZC_LENGTH(HANDLES); i++)
+    {
+        HANDLES[i] = ezc_event_subscribe(BUS, "many",
+                (void (*)(void*, void*)) count, &calls);
+    }
+
+    for (i = 0; i < EZC_LENGTH(HANDLES); i += 2)
+    {
+        if (ezc_event_unsubscribe(BUS, HANDLES[i]) != 0) return 1;
+    }
+
+    if (ezc_event_publish(BUS, "many", NULL) != EZC_LENGTH(HANDLES) / 2 ||
+            calls != EZC_LENGTH(HANDLES) / 2) return 1;
+    printf("-- many : length=%li --\n", ezc_event_length(BUS, "many"));
+
+    /* Remaining handles still work after compaction */
+    for (i = 1; i < EZC_LENGTH(HANDLES); i += 2)
+    {
+        if (ezc_event_unsubscribe(BUS, HANDLES[i]) != 0) return 1;
+    }
+
+    if (ezc_event_length(BUS, "many") != 0) return 1;
+
+    ezc_event_delete(BUS);
+    if (BUS != NULL) return 1;
+
+    return 0;
+}
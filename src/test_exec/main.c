@@ -0,0 +1,151 @@
+/*  test_exec/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_exec/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_atomic.h"
+#include "ezc/ezc_callback.h"
+#include "ezc/ezc_exec.h"
+#include "ezc/ezc_list.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+
+
+
+static ezc_exec *EXEC;
+
+
+
+void square(long *n)
+{
+    *n *= *n;
+}
+
+
+
+void count(long *calls)
+{
+    EZC_ATOMIC_ADD(calls, 1);
+}
+
+
+
+/* Sums up `from` through `to` by splitting the range in two halves that are
+ * summed in parallel */
+typedef struct range { long from, to, sum; } range;
+
+void sum(range *self)
+{
+    if (self->to - self->from < 64)
+    {
+        long i;
+        for (i = self->from; i <= self->to; i++) self->sum += i;
+    }
+    else
+    {
+        long const MID = (self->from + self->to) / 2;
+        range left = { 0 }, right = { 0 };
+        ezc_callback *calls[2];
+        ezc_exec_group group = { 0 };
+
+        left.from = self->from;
+        left.to = MID;
+        right.from = MID + 1;
+        right.to = self->to;
+
+        calls[0] = ezc_callback_new((void (*)(void*)) sum, &left);
+        calls[1] = ezc_callback_new((void (*)(void*)) sum, &right);
+        ezc_exec_submit(EXEC, &group, calls[0]);
+        ezc_exec_submit(EXEC, &group, calls[1]);
+        ezc_exec_wait(EXEC, &group);
+        ezc_callback_delete(calls[0]);
+        ezc_callback_delete(calls[1]);
+
+        self->sum = left.sum + right.sum;
+    }
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    long numbers[5] = { 1, 2, 3, 4, 5 }, calls = 0, i;
+    ezc_list *list = ezc_list_new(&numbers[0], &numbers[1], &numbers[2],
+            &numbers[3], &numbers[4]);
+
+    EXEC = ezc_exec_new(4);
+    if (EXEC == NULL) return 1;
+
+    printf("Squaring in parallel...\n");
+    ezc_exec_map(EXEC, list, square);
+    for (i = 0; i < EZC_LENGTH(numbers); i++)
+    {
+        printf("%li ", numbers[i]);
+        if (numbers[i] != (i + 1) * (i + 1)) return 1;
+    }
+    printf("\n");
+    ezc_list_delete(list);
+
+    printf("Submitting 100000 callbacks...\n");
+    {
+        ezc_callback *callback = ezc_callback_new((void (*)(void*)) count,
+                &calls);
+        ezc_exec_group group = { 0 };
+
+        for (i = 0; i < 100000; i++) ezc_exec_submit(EXEC, &group, callback);
+        ezc_exec_wait(EXEC, &group);
+
+        printf("-- calls=%li --\n", calls);
+        if (calls != 100000 || group.pending != 0) return 1;
+        ezc_callback_delete(callback);
+    }
+
+    printf("Summing recursively...\n");
+    {
+        range all = { 0 };
+
+        all.from = 1;
+        all.to = 100000;
+        sum(&all);
+
+        printf("-- sum=%li --\n", all.sum);
+        if (all.sum != 100000L * 100001L / 2) return 1;
+    }
+
+    printf("Deleting with callbacks pending...\n");
+    {
+        ezc_callback *callback = ezc_callback_new((void (*)(void*)) count,
+                &calls);
+
+        calls = 0;
+        for (i = 0; i < 1000; i++) ezc_exec_submit(EXEC, NULL, callback);
+        ezc_exec_delete(EXEC);
+
+        printf("-- calls=%li --\n", calls);
+        if (calls != 1000 || EXEC != NULL) return 1;
+        ezc_callback_delete(callback);
+    }
+
+    return 0;
+}
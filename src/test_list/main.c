@@ -25,10 +25,37 @@
  */
 
 #include "ezc/ezc_list.h"
+#include "ezc/ezc_log.h"
 #include "ezc/ezc_mem.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+EZC_LIST_DECLARE(int_list, int)
+EZC_LIST_DEFINE(int_list)
+
+static void* failing_alloc(void *context, size_t size)
+{
+    return NULL;
+}
+
+
+
+static void* failing_realloc(void *context, void *ptr, size_t size)
+{
+    return NULL;
+}
+
+
+
+static void failing_free(void *context, void *ptr)
+{
+    free(ptr);
+}
+
+
+
 void printme(char *str)
 {
     printf("[printme]: ");
@@ -44,6 +71,37 @@ void printme(char *str)
 
 
 
+/* Lists left behind by one thread for another to delete */
+static ezc_list *handed[4];
+static pthread_mutex_t handed_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/* Makes and deletes lists, deleting some that other threads made */
+void* churn(void *length)
+{
+    long i, j;
+
+    for (i = 0; i < 2000; i++)
+    {
+        ezc_list *list = ezc_list_new("Seal"), *swap;
+
+        for (j = 0; j < 16; j++) ezc_list_push_front(list, "Walrus");
+
+        pthread_mutex_lock(&handed_lock);
+        swap = handed[i % EZC_LENGTH(handed)];
+        handed[i % EZC_LENGTH(handed)] = list;
+        pthread_mutex_unlock(&handed_lock);
+
+        *(long *) length += ezc_list_length(swap);
+        ezc_list_delete(swap);
+    }
+
+    return NULL;
+}
+
+
+
 int main(int argc, char *argv[])
 {
     size_t const TOTAL = 3;
@@ -123,5 +181,146 @@ int main(int argc, char *argv[])
         ezc_list_delete(names[i]);
     }
 
+    EZC_FREE(names);
+
+
+    {
+        ezc_list_handle *queue = ezc_list_handle_new("Bella", "Christy");
+
+        ezc_list_handle_push_back(queue, "Monica", "Natalie");
+        ezc_list_handle_push_front(queue, "Amanda");
+        ezc_list_handle_erase_front(queue);
+
+        printf("\n-- Handle : length=%li, tail=%s --\n",
+                ezc_list_handle_length(queue), queue->tail->data);
+        ezc_list_map(queue->head, printme);
+
+        ezc_list_handle_delete(queue);
+    }
+
+
+    {
+        /* Spans several pool slabs, then hands them all back at once */
+        ezc_list *many = NULL;
+
+        for (i = 0; i < 5000; i++)
+        {
+            ezc_list_push_front(many, "Polar Bear");
+        }
+
+        printf("\n-- Pooled list : length=%li --\n", ezc_list_length(many));
+        ezc_list_delete(many);
+        ezc_list_pool_trim();
+    }
+
+
+    {
+        /* Lists may be made and deleted by any thread */
+        pthread_t threads[4];
+        long lengths[EZC_LENGTH(threads)] = { 0 };
+
+        for (i = 0; i < EZC_LENGTH(threads); i++)
+        {
+            pthread_create(&threads[i], NULL, churn, &lengths[i]);
+        }
+
+        for (i = 0; i < EZC_LENGTH(threads); i++)
+        {
+            pthread_join(threads[i], NULL);
+            if (i > 0) lengths[0] += lengths[i];
+        }
+
+        for (i = 0; i < EZC_LENGTH(handed); i++)
+        {
+            lengths[0] += ezc_list_length(handed[i]);
+            ezc_list_delete(handed[i]);
+        }
+
+        printf("\n-- Threaded lists : length=%li --\n", lengths[0]);
+        if (lengths[0] != 17L * 2000 * EZC_LENGTH(threads)) return 1;
+    }
+
+
+    {
+        /* Request-scoped list, freed along with its arena */
+        ezc_arena *arena = ezc_arena_new(0);
+        ezc_list_handle *queue = ezc_list_handle_new_arena(arena, "Bella");
+
+        for (i = 0; i < 5000; i++)
+        {
+            ezc_list_handle_push_back(queue, "Penguin");
+        }
+
+        ezc_list_handle_erase_front(queue);
+        printf("\n-- Arena handle : length=%li, tail=%s --\n",
+                ezc_list_handle_length(queue), queue->tail->data);
+
+        ezc_list_handle_delete(queue);
+        ezc_arena_delete(arena);
+    }
+
+
+    {
+        /* Pushes that run out of memory push nothing at all */
+        ezc_allocator failing =
+        {
+            failing_alloc, failing_realloc, failing_free, NULL
+        };
+        ezc_allocator const * const GLOBAL = EZC_MEM_GLOBAL;
+        ezc_arena *arena = ezc_arena_new(64);
+        ezc_list_handle *queue = ezc_list_handle_new_arena(arena, "Bella");
+
+        /* The log needs memory of its own to report the failures */
+        ezc_log(EZC_LOG_INFO, "Running out of memory on purpose.");
+
+        ezc_mem_allocator(&failing);
+        ezc_list_handle_push_back(queue, "A", "B", "C", "D", "E", "F", "G");
+        ezc_list_handle_push_front(queue, "A", "B", "C", "D", "E", "F", "G");
+        if (ezc_list_handle_new("Seal") != NULL) return 1;
+        ezc_mem_allocator(GLOBAL);
+
+        printf("\n-- Out of memory : length=%li, tail=%s --\n",
+                ezc_list_handle_length(queue), queue->tail->data);
+        if (ezc_list_handle_length(queue) != 1 ||
+                queue->head != queue->tail) return 1;
+
+        ezc_list_handle_delete(queue);
+        ezc_arena_delete(arena);
+    }
+
+
+    {
+        /* Items store the ints themselves */
+        int_list *numbers = int_list_new(1), *iter;
+        long sum = 0, errors = 0;
+
+        for (iter = numbers, i = 2; i < 1000; i++)
+        {
+            iter = int_list_push_front(&iter->next, i);
+        }
+        int_list_push_back(&numbers, 1000);
+        int_list_push_front(&numbers, 0);
+        int_list_push_at(&numbers, 500, -1);
+
+        if (int_list_get_at(numbers, 500)->data != -1) errors++;
+        int_list_erase_at(&numbers, 500);
+
+        iter = int_list_pop_at(&numbers, 0);
+        if (iter->data != 0 || iter->next != NULL) errors++;
+        int_list_delete(iter);
+
+        for (iter = numbers; iter != NULL; iter = iter->next)
+        {
+            sum += iter->data;
+        }
+
+        printf("-- int_list : length=%li, sum=%li, errors=%li --\n",
+                int_list_length(numbers), sum, errors);
+
+        int_list_delete(numbers);
+        int_list_pool_delete();
+        if (errors != 0 || sum != 500500) return 1;
+    }
+
     return 0;
 }
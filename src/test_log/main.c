@@ -25,11 +25,118 @@
  */
 
 #include "ezc/ezc_log.h"
+#include "ezc/ezc_mem.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+void* spam(void *arg)
+{
+    long const id = (long) arg;
+    int i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        ezc_log((i % 100 == 99 ? EZC_LOG_ERROR : EZC_LOG_INFO),
+                "Thread #%li, message #%i.", id, i);
+    }
+
+    return NULL;
+}
+
+
+
+long count_messages(char const *path)
+{
+    FILE *file = fopen(path, "r");
+    long count = 0;
+    int c, prev = '\n';
+
+    if (file == NULL) return -1;
+
+    /* Every message starts with ">>" at the start of a line */
+    while ((c = fgetc(file)) != EOF)
+    {
+        if (c == '>' && prev == '\n' && fgetc(file) == '>') count++;
+        prev = c;
+    }
+
+    fclose(file);
+    return count;
+}
+
+
+
+/* Count and remove the segments `path`, `path-1`, `path-2`... */
+long count_segments(char const *path, long *segments)
+{
+    char name[64];
+    long count = 0, n;
+
+    for (*segments = 0; ; (*segments)++)
+    {
+        if (*segments == 0) sprintf(name, "%s", path);
+        else sprintf(name, "%s-%li", path, *segments);
+
+        if ((n = count_messages(name)) < 0) break;
+
+        count += n;
+        remove(name);
+    }
+
+    return count;
+}
+
+
+
+/* Remove `<prefix><stamp><suffix>` and its `-1`, `-2`... variants for the
+ * stamp of every second from `from` to `to`, as the log names its files */
+void remove_stamped(char const *prefix, char const *suffix, time_t from,
+                    time_t to)
+{
+    char stamp[32], name[128];
+    long n;
+
+    for (; from <= to; from++)
+    {
+        strftime(stamp, sizeof stamp, "%Y-%m-%d-%H-%M-%S", localtime(&from));
+
+        for (n = 0; n < 16; n++)
+        {
+            if (n == 0) sprintf(name, "%s%s%s", prefix, stamp, suffix);
+            else sprintf(name, "%s%s-%li%s", prefix, stamp, n, suffix);
+            remove(name);
+        }
+    }
+}
+
+
+
+void flood(int i)
+{
+    ezc_log(EZC_LOG_WARN, "Flood #%i.", i);
+}
+
+
+
+void mixed(int i)
+{
+    ezc_log(EZC_LOG_WARN, "%i|%5.2f|%-4s|%*li|%.*s|%c|%%|%Lg|%s", i, 3.14159,
+            "ab", 6, 42L, 3, "truncated", 'z', (long double) 0.5, NULL);
+}
 
 
 
 int main(int argc, char *argv[])
 {
+    time_t since;
+    int i;
+
     ezc_log_echo(stdout);
 
     ezc_log(EZC_LOG_INFO, "Some boring info. Blah!");
@@ -40,10 +147,342 @@ int main(int argc, char *argv[])
     printf("<ezc_log_get>\n%s</ezc_log_get>\n", ezc_log_get(EZC_LOG_WARN));
 
     printf("Writing log to file...\n");
+    since = time(NULL);
     ezc_log_fwrite();
+    remove_stamped("", ".error", since, time(NULL));
     printf("Clearing log...\n");
     ezc_log_clear();
 
+    printf("Logging asynchronously...\n");
+    ezc_log_async_start(4, EZC_LOG_FULL_BLOCK);
+
+    for (i = 0; i < 8; i++)
+    {
+        ezc_log(EZC_LOG_INFO, "Asynchronous message #%i.", i);
+    }
+
+    ezc_log_flush();
+    ezc_log_async_stop();
+    printf("Clearing log...\n");
+    ezc_log_clear();
+
+    printf("Keeping only the 2 most recent messages...\n");
+    ezc_log_capacity(2, 0);
+    ezc_log(EZC_LOG_ERROR, "This gets overwritten.");
+    ezc_log(EZC_LOG_INFO, "Overwriting #1.");
+    ezc_log(EZC_LOG_INFO, "Overwriting #2.");
+    printf("<ezc_log_get>\n%s</ezc_log_get>\n", ezc_log_get(EZC_LOG_ERROR));
+    printf("<ezc_log_get>\n%s</ezc_log_get>\n", ezc_log_get(EZC_LOG_INFO));
+    ezc_log_capacity(0, 0);
+    printf("Clearing log...\n");
+    ezc_log_clear();
+
+    {
+        pthread_t threads[4];
+        long t;
+
+        printf("Logging from %li threads at once...\n", EZC_LENGTH(threads));
+        ezc_log_echo(NULL);
+        ezc_log_async_start(64, EZC_LOG_FULL_DROP_OLDEST);
+
+        for (t = 0; t < EZC_LENGTH(threads); t++)
+        {
+            pthread_create(&threads[t], NULL, spam, (void *) t);
+        }
+
+        ezc_log_capacity(500, 0);
+        printf("<ezc_log_get>\n%s</ezc_log_get>\n",
+                ezc_log_get(EZC_LOG_ERROR));
+
+        for (t = 0; t < EZC_LENGTH(threads); t++)
+        {
+            pthread_join(threads[t], NULL);
+        }
+
+        ezc_log_async_stop();
+        ezc_log_echo(stdout);
+
+        printf("<ezc_log_get>\n%s</ezc_log_get>\n",
+                ezc_log_get(EZC_LOG_ERROR));
+        ezc_log_capacity(0, 0);
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
+    printf("Only logging warnings and worse...\n");
+    ezc_log_level(EZC_LOG_WARN);
+    ezc_log(EZC_LOG_INFO, "Skipped message #%i.", ++i);
+    ezc_log(EZC_LOG_WARN, "Logged message #%i.", ++i);
+    ezc_log_level(EZC_LOG_INFO);
+    printf("<ezc_log_get>\n%s</ezc_log_get>\n", ezc_log_get(EZC_LOG_INFO));
+    if (i != 9) return 1;
+    printf("Clearing log...\n");
+    ezc_log_clear();
+
+    {
+        char text[256], decoded[256];
+        FILE *dump = tmpfile(), *out = tmpfile();
+        long length;
+
+        printf("Logging in binary...\n");
+        ezc_log_echo(NULL);
+        mixed(7);
+        strcpy(text, ezc_log_get(EZC_LOG_INFO));
+
+        ezc_log_clear();
+        ezc_log_mode(EZC_LOG_MODE_BINARY);
+        mixed(7);
+        ezc_log_mode(EZC_LOG_MODE_TEXT);
+        printf("<ezc_log_get>\n%s</ezc_log_get>\n",
+                ezc_log_get(EZC_LOG_INFO));
+        if (strcmp(text, ezc_log_get(EZC_LOG_INFO)) != 0) return 1;
+
+        printf("Dumping and decoding log...\n");
+        ezc_log_dump(dump);
+        rewind(dump);
+        if (ezc_log_decode(dump, out) != 1) return 1;
+        rewind(out);
+        length = fread(decoded, sizeof(char), sizeof decoded - 1, out);
+        decoded[length] = '\0';
+        if (strcmp(text, decoded) != 0) return 1;
+
+        /* A corrupt file name length must not make decoding overflow */
+        length = LONG_MAX - 8;
+        fseek(dump, sizeof "EZCLOG1\n" - 1 + 6 * sizeof(long), SEEK_SET);
+        fwrite(&length, sizeof(long), 1, dump);
+        rewind(dump);
+        if (ezc_log_decode(dump, out) != -1) return 1;
+
+        /* Nor may a text record that leaves no room for its terminator */
+        {
+            long header[8] = {0};
+
+            header[5] = 4096;
+            rewind(dump);
+            fwrite("EZCLOG1\n", sizeof(char), sizeof "EZCLOG1\n" - 1, dump);
+            fwrite(header, sizeof(long), 8, dump);
+            for (length = 0; length < header[5]; length++) fputc('x', dump);
+            rewind(dump);
+            if (ezc_log_decode(dump, out) != -1) return 1;
+        }
+
+        fclose(dump);
+        fclose(out);
+        ezc_log_echo(stdout);
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
+    printf("Appending log to file...\n");
+    remove("test_log.txt");
+    if (ezc_log_file_open("test_log.txt", 0, 0, EZC_LOG_SYNC_BUFFERED))
+    {
+        return 1;
+    }
+    for (i = 0; i < 3; i++) ezc_log(EZC_LOG_INFO, "To file #%i.", i);
+    ezc_log_file_close();
+    if (count_messages("test_log.txt") != 3) return 1;
+
+    ezc_log_file_open("test_log.txt", 0, 0, EZC_LOG_SYNC_FLUSH);
+    ezc_log(EZC_LOG_INFO, "Appended.");
+    if (count_messages("test_log.txt") != 4) return 1;
+
+    printf("Rotating log file...\n");
+    since = time(NULL);
+    ezc_log_file_open("test_log.txt", 1, 0, EZC_LOG_SYNC_FSYNC);
+    ezc_log(EZC_LOG_INFO, "Rotated away.");
+    ezc_log(EZC_LOG_INFO, "Rotated away as well.");
+    ezc_log(EZC_LOG_INFO, "Kept.");
+    if (count_messages("test_log.txt") != 1) return 1;
+    ezc_log_file_close();
+    remove("test_log.txt");
+    remove_stamped("test_log.txt.", "", since, time(NULL));
+    printf("Clearing log...\n");
+    ezc_log_clear();
+
+    {
+        pthread_t threads[4];
+        long t, segments;
+
+        printf("Logging into memory-mapped segments...\n");
+        count_segments("test_log.seg", &segments);
+        if (ezc_log_segment_open("test_log.seg", 256)) return 1;
+        for (i = 0; i < 10; i++) ezc_log(EZC_LOG_INFO, "Mapped #%i.", i);
+        ezc_log_segment_close();
+        if (count_segments("test_log.seg", &segments) != 10) return 1;
+        printf("-- 10 messages in %li segments --\n", segments);
+
+        /* Asynchronous messages reach the segment before the writer */
+        ezc_log_async_start(64, EZC_LOG_FULL_BLOCK);
+        ezc_log_segment_open("test_log.seg", 256);
+        for (i = 0; i < 10; i++) ezc_log(EZC_LOG_INFO, "Queued #%i.", i);
+        ezc_log_segment_close();
+        ezc_log_async_stop();
+        if (count_segments("test_log.seg", &segments) != 10) return 1;
+
+        ezc_log_echo(NULL);
+        ezc_log_segment_open("test_log.seg", 16384);
+
+        for (t = 0; t < EZC_LENGTH(threads); t++)
+        {
+            pthread_create(&threads[t], NULL, spam, (void *) t);
+        }
+
+        for (t = 0; t < EZC_LENGTH(threads); t++)
+        {
+            pthread_join(threads[t], NULL);
+        }
+
+        ezc_log_segment_close();
+        ezc_log_echo(stdout);
+        if (count_segments("test_log.seg", &segments) != 4000) return 1;
+        printf("-- 4000 messages in %li segments --\n", segments);
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
+    {
+        ezc_log_query *query;
+        ezc_log_record const *record;
+        time_t const now = time(NULL);
+        long count = 0;
+
+        printf("Querying log...\n");
+        ezc_log_echo(NULL);
+        ezc_log_capacity(200000, 0);
+        ezc_log(EZC_LOG_ERROR, "Buried error.");
+        for (i = 0; i < 100000; i++) ezc_log(EZC_LOG_INFO, "Noise #%i.", i);
+        ezc_log(EZC_LOG_WARN, "Latest warning.");
+        ezc_log_echo(stdout);
+
+        printf("<ezc_log_get>\n%s</ezc_log_get>\n",
+                ezc_log_get(EZC_LOG_ERROR));
+        if (strstr(ezc_log_get(EZC_LOG_ERROR), "Buried") == NULL) return 1;
+        if (strstr(ezc_log_get(EZC_LOG_WARN), "Latest") == NULL) return 1;
+        if (strstr(ezc_log_get(EZC_LOG_INFO), "Latest") == NULL) return 1;
+
+        query = ezc_log_query_new(EZC_LOG_WARN, EZC_LOG_ERROR, __FILE__,
+                now - 60, 0);
+
+        /* Logging neither waits for the query nor shows up in it */
+        ezc_log(EZC_LOG_ERROR, "Logged while querying.");
+        if (strstr(ezc_log_get(EZC_LOG_ERROR), "querying") == NULL) return 1;
+
+        while ((record = ezc_log_query_next(query)) != NULL)
+        {
+            printf("[%s:%li] %s", record->file, record->line,
+                    record->message);
+            count++;
+        }
+        ezc_log_query_delete(query);
+        if (count != 2 || query != NULL) return 1;
+
+        query = ezc_log_query_new(EZC_LOG_INFO, EZC_LOG_FATAL, "nope.c", 0,
+                0);
+        if (ezc_log_query_next(query) != NULL) return 1;
+        ezc_log_query_delete(query);
+
+        ezc_log_capacity(0, 0);
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
+    {
+        ezc_log_query *query;
+        ezc_log_record const *record;
+        long count = 0;
+
+        printf("Rate limiting to 5 messages per second, sampling 1 in 10...\n");
+        ezc_log_echo(NULL);
+        ezc_log_rate(5, 10);
+        for (i = 0; i < 100; i++) flood(i);
+
+        /* The flood might straddle two seconds */
+        query = ezc_log_query_new(EZC_LOG_WARN, EZC_LOG_WARN, NULL, 0, 0);
+        while (ezc_log_query_next(query) != NULL) count++;
+        ezc_log_query_delete(query);
+        printf("-- %li of 100 messages logged --\n", count);
+        if (count < 5 + 9 || count > 2 * (5 + 10) + 1) return 1;
+
+        /* A new second reports what was dropped */
+        sleep(1);
+        ezc_log_echo(stdout);
+        flood(100);
+        ezc_log_rate(0, 0);
+
+        count = 0;
+        query = ezc_log_query_new(EZC_LOG_WARN, EZC_LOG_WARN, NULL, 0, 0);
+        while ((record = ezc_log_query_next(query)) != NULL)
+        {
+            if (strstr(record->message, "Suppressed") != NULL) count++;
+        }
+        ezc_log_query_delete(query);
+        if (count != 1) return 1;
+
+        /* A call that never logs again still gets its summary */
+        ezc_log_clear();
+        ezc_log_rate(1, 0);
+        for (i = 0; i < 10; i++) ezc_log(EZC_LOG_WARN, "Burst #%i.", i);
+        ezc_log_flush();
+        ezc_log_rate(0, 0);
+        if (strstr(ezc_log_get(EZC_LOG_WARN), "Suppressed") == NULL) return 1;
+
+        /* Still usable as an expression */
+        count = (ezc_log(EZC_LOG_INFO, "Expression."), 1);
+        if (count != 1) return 1;
+
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
+    {
+        FILE *json = tmpfile(), *dump = tmpfile(), *decoded = tmpfile();
+        char line[4096];
+        long count = 0;
+
+        printf("Logging key/value fields...\n");
+        ezc_log_kv(EZC_LOG_WARN, "Slow request.",
+                EZC_LOG_STRING("path", "/index \"html\""),
+                EZC_LOG_INT("ms", 1234), EZC_LOG_DOUBLE("load", 0.5),
+                EZC_LOG_POINTER("self", NULL));
+        if (strstr(ezc_log_get(EZC_LOG_WARN), "ms=1234") == NULL) return 1;
+
+        /* Fields survive the binary mode and a dump as well */
+        ezc_log_mode(EZC_LOG_MODE_BINARY);
+        ezc_log_echo(NULL);
+        ezc_log(EZC_LOG_INFO, "Binary #%i.", 7);
+        ezc_log_echo(stdout);
+        ezc_log_mode(EZC_LOG_MODE_TEXT);
+
+        ezc_log_fwrite_json(json);
+        ezc_log_dump(dump);
+        rewind(dump);
+        if (ezc_log_decode_json(dump, decoded) != 2) return 1;
+
+        rewind(json);
+        while (fgets(line, sizeof line, json) != NULL)
+        {
+            printf("%s", line);
+            if (strstr(line, "\"message\":\"Binary #7.\"") != NULL) count++;
+            if (strstr(line, "\"path\":\"/index \\\"html\\\"\"") != NULL &&
+                    strstr(line, "\"ms\":1234,\"load\":0.5") != NULL) count++;
+        }
+
+        rewind(decoded);
+        while (fgets(line, sizeof line, decoded) != NULL)
+        {
+            if (strstr(line, "\"ms\":1234") != NULL) count++;
+        }
+
+        fclose(json);
+        fclose(dump);
+        fclose(decoded);
+        if (count != 3) return 1;
+
+        printf("Clearing log...\n");
+        ezc_log_clear();
+    }
+
     printf("<ezc_log_get>\n%s</ezc_log_get>\n", ezc_log_get(EZC_LOG_WARN));
 
     return 0;
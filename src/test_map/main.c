@@ -0,0 +1,93 @@
+/*  test_map/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_map/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_map.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+#include <string.h>
+
+void printme(char *key, char *value)
+{
+    printf("[printme]: %s -> %s\n", key, value);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    ezc_map *ages = ezc_map_new(ezc_map_hash_str, strcmp);
+
+    ezc_map_set(ages, "Amanda", "23");
+    ezc_map_set(ages, "Bella", "31");
+    ezc_map_set(ages, "Christy", "27");
+    printf("Overwriting: %s\n", ezc_map_get(ages, "Bella"));
+    if (ezc_map_set(ages, "Bella", "32") != 0) return 1;
+
+    ezc_map_map(ages, printme);
+
+    printf("Get \"%s\": %s\n", "Christy", ezc_map_get(ages, "Christy"));
+    printf("Popped \"%s\": %s\n", "Amanda", ezc_map_pop(ages, "Amanda"));
+    printf("Has \"%s\": %i\n", "Amanda", ezc_map_has(ages, "Amanda"));
+    printf("-- ages : length=%li --\n", ezc_map_length(ages));
+
+    ezc_map_delete(ages);
+
+
+    {
+        /* Pointer keys, erasing every other one to exercise backward shift
+         * deletion */
+        static int keys[50000];
+        ezc_map *map = ezc_map_new(NULL, NULL);
+        long i, errors = 0;
+
+        for (i = 0; i < EZC_LENGTH(keys); i++)
+        {
+            ezc_map_set(map, &keys[i], &keys[EZC_LENGTH(keys) - 1 - i]);
+        }
+
+        for (i = 0; i < EZC_LENGTH(keys); i += 2)
+        {
+            if (ezc_map_pop(map, &keys[i]) !=
+                    &keys[EZC_LENGTH(keys) - 1 - i]) errors++;
+        }
+
+        for (i = 0; i < EZC_LENGTH(keys); i++)
+        {
+            if (ezc_map_has(map, &keys[i]) != (i % 2 == 1)) errors++;
+        }
+
+        printf("-- Pointers : length=%li, capacity=%li, errors=%li --\n",
+                ezc_map_length(map), map->capacity, errors);
+
+        ezc_map_clear(map);
+        if (ezc_map_get(map, &keys[1]) != NULL) errors++;
+        ezc_map_delete(map);
+
+        if (errors != 0) return 1;
+    }
+
+    return 0;
+}
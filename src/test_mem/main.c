@@ -0,0 +1,309 @@
+/*  test_callback/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_mem/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_macro.h"
+#include "ezc/ezc_mem.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static long allocs = 0;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static int stage = 0;
+
+
+
+static void* counting_alloc(void *context, size_t size)
+{
+    allocs++;
+    return malloc(size);
+}
+
+
+
+static void* counting_realloc(void *context, void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+
+
+static void counting_free(void *context, void *ptr)
+{
+    free(ptr);
+}
+
+
+
+static void stage_set(int to)
+{
+    pthread_mutex_lock(&lock);
+    stage = to;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+}
+
+
+
+static void stage_wait(int until)
+{
+    pthread_mutex_lock(&lock);
+    while (stage < until) pthread_cond_wait(&changed, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+
+
+/* Caches objects of a pool that another thread deletes, then carries on with
+ * pools of its own */
+void* outlive(void *pool)
+{
+    ezc_mem_pool *own = ezc_mem_pool_new(sizeof(long));
+    long *object;
+
+    ezc_mem_pool_free(own, ezc_mem_pool_alloc(own));
+    ezc_mem_pool_free(pool, ezc_mem_pool_alloc(pool));
+
+    stage_set(1);
+    stage_wait(2);
+
+    object = ezc_mem_pool_alloc(own);
+    if (object != NULL) *object = 1;
+    ezc_mem_pool_free(own, object);
+    ezc_mem_pool_delete(own);
+
+    return object;
+}
+
+
+
+/* Frees objects allocated by the main thread */
+void* give_back(void *pool)
+{
+    long **objects = ((void **) pool)[1];
+    long i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        ezc_mem_pool_free(((void **) pool)[0], objects[i]);
+    }
+
+    return NULL;
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    long errors = 0;
+
+
+    {
+        /* Pooled objects are aligned, distinct and get reused */
+        ezc_mem_pool *pool = ezc_mem_pool_new(sizeof(double) * 3);
+        static double *objects[10000];
+        long i;
+
+        for (i = 0; i < EZC_LENGTH(objects); i++)
+        {
+            objects[i] = ezc_mem_pool_alloc(pool);
+            if (objects[i] == NULL ||
+                    (unsigned long) objects[i] % sizeof(double) != 0) errors++;
+            else objects[i][0] = objects[i][2] = i;
+        }
+
+        for (i = 0; i < EZC_LENGTH(objects); i++)
+        {
+            if (objects[i][0] != i || objects[i][2] != i) errors++;
+        }
+
+        for (i = EZC_LENGTH(objects) - 1; i >= 0; i--)
+        {
+            ezc_mem_pool_free(pool, objects[i]);
+        }
+
+        if (ezc_mem_pool_alloc(pool) != objects[0]) errors++;
+        ezc_mem_pool_delete(pool);
+
+        printf("-- reuse : errors=%li --\n", errors);
+        if (pool != NULL) errors++;
+    }
+
+
+    {
+        /* A chain goes back whole, linked through any member */
+        typedef struct node { long value; struct node *next; } node;
+        ezc_mem_pool *pool = ezc_mem_pool_new(sizeof(node));
+        node *head = NULL, *iter;
+        long i, found = 0;
+
+        for (i = 0; i < 1000; i++)
+        {
+            if ((iter = ezc_mem_pool_alloc(pool)) == NULL)
+            {
+                errors++;
+                continue;
+            }
+
+            iter->next = head;
+            head = iter;
+        }
+
+        iter = head;
+        if (ezc_mem_pool_free_chain(pool, head, offsetof(node, next)) !=
+                1000) errors++;
+        if (ezc_mem_pool_free_chain(pool, NULL, 0) != 0) errors++;
+
+        for (i = 0; i < 1000; i++)
+        {
+            if (ezc_mem_pool_alloc(pool) == iter) found++;
+        }
+
+        ezc_mem_pool_delete(pool);
+
+        printf("-- chain : errors=%li --\n", errors);
+        if (found != 1) errors++;
+    }
+
+
+    {
+        /* Far more pools than there are thread-specific keys */
+        static ezc_mem_pool *pools[4096];
+        static long *objects[EZC_LENGTH(pools)];
+        long i;
+
+        for (i = 0; i < EZC_LENGTH(pools); i++)
+        {
+            pools[i] = ezc_mem_pool_new(sizeof(long));
+            objects[i] = (pools[i] != NULL ?
+                    ezc_mem_pool_alloc(pools[i]) : NULL);
+
+            if (objects[i] == NULL) errors++;
+            else *objects[i] = i;
+        }
+
+        for (i = 0; i < EZC_LENGTH(pools); i++)
+        {
+            if (objects[i] == NULL || *objects[i] != i) errors++;
+            ezc_mem_pool_free(pools[i], objects[i]);
+            ezc_mem_pool_delete(pools[i]);
+        }
+
+        printf("-- many : errors=%li --\n", errors);
+    }
+
+
+    {
+        /* Objects may be freed by another thread, and a pool may be deleted
+         * while another thread still caches some of its objects */
+        ezc_mem_pool *pool = ezc_mem_pool_new(sizeof(long));
+        static long *objects[1000];
+        void *args[2];
+        pthread_t thread;
+        void *result;
+        long i;
+
+        for (i = 0; i < EZC_LENGTH(objects); i++)
+        {
+            objects[i] = ezc_mem_pool_alloc(pool);
+            if (objects[i] == NULL) errors++;
+        }
+
+        args[0] = pool;
+        args[1] = objects;
+        pthread_create(&thread, NULL, give_back, args);
+        pthread_join(thread, NULL);
+
+        for (i = 0; i < EZC_LENGTH(objects); i++)
+        {
+            if (ezc_mem_pool_alloc(pool) == NULL) errors++;
+        }
+
+        pthread_create(&thread, NULL, outlive, pool);
+        stage_wait(1);
+        ezc_mem_pool_delete(pool);
+        stage_set(2);
+        pthread_join(thread, &result);
+
+        if (result == NULL) errors++;
+
+        printf("-- threads : errors=%li --\n", errors);
+    }
+
+
+    {
+        /* A pool sticks to the global allocator it was made with */
+        ezc_allocator counting =
+        {
+            counting_alloc, counting_realloc, counting_free, NULL
+        };
+        ezc_allocator const * const GLOBAL = EZC_MEM_GLOBAL;
+        ezc_mem_pool *pool;
+        long i;
+
+        ezc_mem_allocator(&counting);
+        pool = ezc_mem_pool_new(sizeof(long));
+        ezc_mem_allocator(GLOBAL);
+
+        for (i = 0; i < 10000; i++)
+        {
+            if (ezc_mem_pool_alloc(pool) == NULL) errors++;
+        }
+
+        ezc_mem_pool_delete(pool);
+
+        printf("-- allocator : allocs=%li errors=%li --\n", allocs, errors);
+        if (allocs < 2) errors++;
+    }
+
+
+#ifdef EZC_MEM_TRACK
+    {
+        /* Kept memory, and whatever a kept pool allocates, is not a leak */
+        long const BEFORE = ezc_mem_leaks(NULL);
+        ezc_mem_pool *pool = ezc_mem_pool_new(sizeof(long));
+        long *kept = EZC_MEM_ALLOC(EZC_MEM_GLOBAL, sizeof *kept);
+
+        if (ezc_mem_leaks(NULL) != BEFORE + 2) errors++;
+
+        EZC_MEM_KEEP(pool);
+        EZC_MEM_KEEP(kept);
+        if (ezc_mem_pool_alloc(pool) == NULL) errors++;
+        if (ezc_mem_leaks(NULL) != BEFORE) errors++;
+
+        ezc_mem_pool_delete(pool);
+        EZC_MEM_FREE(EZC_MEM_GLOBAL, kept);
+        if (ezc_mem_leaks(NULL) != BEFORE) errors++;
+
+        printf("-- keep : errors=%li --\n", errors);
+    }
+#endif
+
+    return errors != 0;
+}
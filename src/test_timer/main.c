@@ -0,0 +1,161 @@
+/*  test_timer/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_timer/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_callback.h"
+#include "ezc/ezc_mem.h"
+#include "ezc/ezc_timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+static ezc_timer *TIMER;
+static long NOW;
+
+
+
+typedef struct alarm
+{
+    char const *name;
+    long deadline, fired, errors;
+    ezc_timer_handle handle;
+}
+alarm;
+
+
+
+void ring(alarm *self)
+{
+    printf("[%li] %s\n", NOW, self->name);
+    self->fired++;
+}
+
+
+
+/* Checks that it expires right on time, and only once */
+void check(alarm *self)
+{
+    if (self->deadline != NOW || self->fired++ != 0) self->errors++;
+}
+
+
+
+/* Cancels itself the third time around */
+void snooze(alarm *self)
+{
+    ring(self);
+    if (self->fired == 3) ezc_timer_cancel(TIMER, self->handle);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    alarm alarms[3] = { { "Once at 5" }, { "Every 3 from 3" },
+        { "Never at 4" } };
+    ezc_callback *calls[3];
+    long i;
+
+    TIMER = ezc_timer_new(0);
+
+    calls[0] = ezc_callback_new((void (*)(void*)) ring, &alarms[0]);
+    calls[1] = ezc_callback_new((void (*)(void*)) snooze, &alarms[1]);
+    calls[2] = ezc_callback_new((void (*)(void*)) ring, &alarms[2]);
+
+    ezc_timer_schedule(TIMER, 5, 0, calls[0]);
+    alarms[1].handle = ezc_timer_schedule(TIMER, 3, 3, calls[1]);
+    alarms[2].handle = ezc_timer_schedule(TIMER, 4, 0, calls[2]);
+    if (ezc_timer_cancel(TIMER, alarms[2].handle) != 0) return 1;
+
+    for (NOW = 1; NOW <= 20; NOW++) ezc_timer_tick(TIMER, NOW);
+
+    if (alarms[0].fired != 1 || alarms[1].fired != 3 ||
+            alarms[2].fired != 0) return 1;
+    if (ezc_timer_cancel(TIMER, alarms[1].handle) != -1) return 1;
+
+    for (i = 0; i < EZC_LENGTH(calls); i++) ezc_callback_delete(calls[i]);
+
+
+    {
+        /* Random deadlines on every level of the wheel */
+        static alarm checks[10000];
+        static ezc_callback *callbacks[EZC_LENGTH(checks)];
+        long const END = 1L << 20;
+        long errors = 0, fired = 0;
+
+        printf("Expiring %li random timers...\n", (long) EZC_LENGTH(checks));
+        srand(42);
+
+        for (i = 0; i < EZC_LENGTH(checks); i++)
+        {
+            checks[i].deadline = NOW + 1 + (rand() % END) / (1 + rand() % 64);
+            callbacks[i] = ezc_callback_new((void (*)(void*)) check,
+                    &checks[i]);
+            checks[i].handle = ezc_timer_schedule(TIMER, checks[i].deadline,
+                    0, callbacks[i]);
+        }
+
+        for (i = 0; i < EZC_LENGTH(checks); i += 3)
+        {
+            ezc_timer_cancel(TIMER, checks[i].handle);
+        }
+
+        for (; NOW <= 2 * END; NOW++) fired += ezc_timer_tick(TIMER, NOW);
+
+        for (i = 0; i < EZC_LENGTH(checks); i++)
+        {
+            errors += checks[i].errors + (checks[i].fired != (i % 3 != 0));
+            ezc_callback_delete(callbacks[i]);
+        }
+
+        printf("-- fired=%li, errors=%li --\n", fired, errors);
+        if (errors != 0) return 1;
+    }
+
+
+    {
+        /* Beyond the top of the wheel, reached in one big jump */
+        alarm far = { "Far out" };
+        ezc_callback *callback = ezc_callback_new((void (*)(void*)) check,
+                &far);
+
+        printf("Jumping far ahead...\n");
+        far.deadline = NOW + (1L << 30) + 12345;
+        ezc_timer_schedule(TIMER, far.deadline, 0, callback);
+
+        if (ezc_timer_tick(TIMER, far.deadline - 1) != 0) return 1;
+        NOW = far.deadline;
+        if (ezc_timer_tick(TIMER, NOW + 1000) != 1) return 1;
+        if (far.errors != 0) return 1;
+
+        ezc_callback_delete(callback);
+    }
+
+    ezc_timer_delete(TIMER);
+    if (TIMER != NULL) return 1;
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*  test_ulist/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_ulist/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_ulist.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void printme(char *str)
+{
+    printf("[printme]: %s\n", str);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    ezc_ulist *names = ezc_ulist_new("Monica", "Natalie");
+    ezc_ulist *copy;
+
+    ezc_ulist_push_at(names, 2, "Olivia"); /* Equivalent to push_back */
+    ezc_ulist_push_front(names, "Amanda", "Bella", "Christy");
+    ezc_ulist_push_back(names, "Xiaotian", "Yana");
+
+    copy = ezc_ulist_copy(names);
+    ezc_ulist_cat(names, ezc_ulist_new("Zoe"));
+
+    ezc_ulist_map(names, printme);
+
+    printf("testing get_at 1: %s\n", ezc_ulist_get_at(names, 1));
+    printf("POPPED: %s\n", ezc_ulist_pop_at(names, 3));
+    ezc_ulist_erase_match_fn(names, strcmp, "Zoe");
+    printf("Find index of \"%s\": %li\n", "Yana",
+            ezc_ulist_get_index_of_fn(names, strcmp, "Yana"));
+    printf("Find index of \"%s\": %li\n", "Zack",
+            ezc_ulist_get_index_of_fn(names, strcmp, "Zack"));
+    printf("-- names : length=%li, copy : length=%li --\n",
+            ezc_ulist_length(names), ezc_ulist_length(copy));
+
+    ezc_ulist_delete(names, copy);
+
+
+    {
+        /* Pushing to either end keeps every block but one full */
+        static int values[1000];
+        ezc_ulist *front = NULL, *back = NULL, *iter;
+        long i, blocks = 0;
+
+        for (i = 0; i < 1000; i++)
+        {
+            ezc_ulist_push_front(front, &values[i]);
+            ezc_ulist_push_back(back, &values[i]);
+        }
+
+        for (iter = front; iter != NULL; iter = iter->next) blocks++;
+        for (iter = back; iter != NULL; iter = iter->next) blocks++;
+
+        printf("-- Pushed : blocks=%li --\n", blocks);
+
+        if (ezc_ulist_get_at(front, 0) != &values[999] ||
+                ezc_ulist_get_at(back, 0) != &values[0] ||
+                blocks != 2 * ((1000 + EZC_ULIST_CAPACITY - 1) /
+                    EZC_ULIST_CAPACITY))
+        {
+            return 1;
+        }
+
+        ezc_ulist_delete(front, back);
+    }
+
+
+    {
+        /* Random pushes and pops, checked against a plain array */
+        static int values[4096];
+        int *expect[4096];
+        ezc_ulist *list = NULL;
+        long i, j, length = 0, errors = 0;
+
+        srand(42);
+
+        for (i = 0; i < 20000; i++)
+        {
+            long n = (length == 0 ? 0 : rand() % (length + 1));
+
+            if (length < 16 || (length < 4096 && rand() % 3 != 0))
+            {
+                int *v = &values[i % 4096];
+                ezc_ulist_push_at(list, n, v);
+                memmove(&expect[n+1], &expect[n],
+                        (length - n) * sizeof expect[0]);
+                expect[n] = v;
+                length++;
+            }
+            else
+            {
+                n %= length;
+                if (ezc_ulist_pop_at(list, n) != expect[n]) errors++;
+                memmove(&expect[n], &expect[n+1],
+                        (length - n - 1) * sizeof expect[0]);
+                length--;
+            }
+        }
+
+        if (ezc_ulist_length(list) != length) errors++;
+
+        for (j = 0; j < length; j++)
+        {
+            if (ezc_ulist_get_at(list, j) != expect[j]) errors++;
+        }
+
+        printf("-- Random : length=%li, errors=%li --\n", length, errors);
+        ezc_ulist_delete(list);
+
+        if (errors != 0) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*  test_vec/main.c
+ *
+ *  Copyright (c) 2018 Kirk Lange <github.com/kirklange>
+ *
+ *  This software is provided 'as-is', without any express or implied
+ *  warranty. In no event will the authors be held liable for any damages
+ *  arising from the use of this software.
+ *
+ *  Permission is granted to anyone to use this software for any purpose,
+ *  including commercial applications, and to alter it and redistribute it
+ *  freely, subject to the following restrictions:
+ *
+ *  1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *  2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ *  3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** @file       test_vec/main.c
+ *  @brief      Lorem ipsum
+ *  @details    Lorem ipsum dolor sit amet, consectetur adipiscing elit.
+ */
+
+#include "ezc/ezc_vec.h"
+#include "ezc/ezc_mem.h"
+#include <stdio.h>
+#include <string.h>
+
+struct point
+{
+    double x, y;
+};
+
+EZC_VEC_DEFINE(point_vec, struct point)
+
+void printme(char *str)
+{
+    printf("[printme]: %s\n", str);
+}
+
+
+
+/* Standard library allocator that counts outstanding allocations */
+void* counted_alloc(void *context, size_t size)
+{
+    ++*(long *) context;
+    return malloc(size);
+}
+
+void* counted_realloc(void *context, void *ptr, size_t size)
+{
+    if (ptr == NULL) ++*(long *) context;
+    return realloc(ptr, size);
+}
+
+void counted_free(void *context, void *ptr)
+{
+    --*(long *) context;
+    free(ptr);
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    char const *more[] = { "Xiaotian", "Yana", "Zoe" };
+    ezc_vec *names = ezc_vec_new("Monica", "Natalie");
+    ezc_vec *copy;
+    long i;
+
+    ezc_vec_push_at(names, 2, "Olivia"); /* Equivalent to push_back */
+    ezc_vec_push_front(names, "Amanda", "Bella", "Christy");
+    ezc_vec_push_array(names, ezc_vec_length(names), more, EZC_LENGTH(more));
+
+    ezc_vec_map(names, printme);
+
+    printf("testing get_at 1: %s\n", ezc_vec_get_at(names, 1));
+    printf("POPPED: %s\n", ezc_vec_pop_at(names, 3));
+    printf("POPPED: %s\n", ezc_vec_pop_back(names));
+    printf("Find index of \"%s\": %li\n", "Yana",
+            ezc_vec_get_index_of_fn(names, strcmp, "Yana"));
+    printf("Find index of \"%s\": %li\n", "Zack",
+            ezc_vec_get_index_of_fn(names, strcmp, "Zack"));
+
+    copy = ezc_vec_copy(names);
+    ezc_vec_clear(names);
+
+    for (i = 0; i < 100000; i++)
+    {
+        ezc_vec_push_back(names, "Polar Bear");
+    }
+
+    printf("-- names : length=%li, capacity=%li --\n",
+            ezc_vec_length(names), ezc_vec_capacity(names));
+
+    while (ezc_vec_length(names) > 10) ezc_vec_pop_back(names);
+    ezc_vec_shrink_to_fit(names);
+    ezc_vec_reserve(copy, 64);
+
+    printf("-- names : length=%li, capacity=%li --\n",
+            ezc_vec_length(names), ezc_vec_capacity(names));
+    printf("-- copy : length=%li, capacity=%li --\n",
+            ezc_vec_length(copy), ezc_vec_capacity(copy));
+
+    ezc_vec_delete(names, copy);
+
+
+    {
+        long outstanding = 0, global = 0;
+        ezc_allocator counted = { counted_alloc, counted_realloc,
+                                  counted_free, NULL };
+        ezc_allocator counted_global = { counted_alloc, counted_realloc,
+                                         counted_free, NULL };
+        ezc_vec *vec, *dup, *plain;
+
+        counted.context = &outstanding;
+        counted_global.context = &global;
+
+        vec = ezc_vec_new_allocator(&counted, "Alpha", "Beta");
+        for (i = 0; i < 1000; i++) ezc_vec_push_back(vec, "Gamma");
+        dup = ezc_vec_copy(vec);
+        ezc_vec_shrink_to_fit(vec);
+
+        /* Vectors without their own allocator follow the global one */
+        ezc_mem_allocator(&counted_global);
+        plain = ezc_vec_new("Delta");
+        ezc_vec_push_back(plain, "Epsilon");
+
+        printf("-- counted : outstanding=%li, global=%li --\n",
+                outstanding, global);
+
+        if (outstanding != 4 || global != 2) return 1;
+
+        ezc_vec_delete(vec, dup, plain);
+        ezc_mem_allocator(NULL);
+
+        printf("-- counted : outstanding=%li, global=%li --\n",
+                outstanding, global);
+
+        if (outstanding != 0 || global != 0) return 1;
+    }
+
+
+    {
+        /* Points stored by value, one after another */
+        point_vec *points = point_vec_new();
+        struct point point, *last;
+        long errors = 0;
+
+        for (i = 0; i < 1000; i++)
+        {
+            point.x = i;
+            point.y = -i;
+            last = point_vec_push_back(points, point);
+        }
+
+        if (last != &points->data[999] || last->y != -999) errors++;
+
+        point.x = point.y = 0.5;
+        point_vec_push_at(points, 0, point);
+        point_vec_set_at(points, 1, point);
+
+        if (point_vec_get_at(points, 1)->x != 0.5) errors++;
+        if (point_vec_pop_at(points, 0).y != 0.5) errors++;
+        if (point_vec_pop_back(points).x != 999) errors++;
+
+        point_vec_shrink_to_fit(points);
+
+        printf("-- point_vec : length=%li, capacity=%li, errors=%li --\n",
+                point_vec_length(points), points->capacity, errors);
+
+        if (errors != 0 || points->data[998].x != 998) return 1;
+
+        point_vec_clear(points);
+        point_vec_shrink_to_fit(points);
+        point_vec_delete(points);
+    }
+
+
+#ifdef EZC_MEM_TRACK
+    {
+        ezc_mem_stats before, during, after;
+        ezc_vec *vec;
+
+        ezc_mem_stats_get("ezc_vec", &before);
+
+        vec = ezc_vec_new("Alpha");
+        for (i = 0; i < 1000; i++) ezc_vec_push_back(vec, "Beta");
+
+        ezc_mem_stats_get("ezc_vec", &during);
+        ezc_vec_delete(vec);
+        ezc_mem_stats_get("ezc_vec", &after);
+
+        ezc_mem_dump(stdout);
+
+        if (during.live - before.live < 1000 * (long) sizeof(void *) ||
+                after.live != before.live ||
+                after.allocs - after.frees != before.allocs - before.frees ||
+                ezc_mem_stats_get("ezc_nothing", &after) != -1)
+        {
+            return 1;
+        }
+    }
+#endif
+
+    return 0;
+}